@@ -5,6 +5,7 @@
 ***************************************************************************/
 
 #include <assert.h>
+#include <float.h>
 #include <limits.h>
 // #include <stdio.h>
 #include <string.h>
@@ -23,32 +24,53 @@
 #include "game.h"
 
 #include "asteroids.h"
+#include "profile.h"
+#include "simd.h"
 
+#include "gl.c"
+#include "profile.c"
+#include "jobs.c"
+#include "render_target.c"
+
+#include "audio.c"
 #include "bloom.c"
+#include "capture.c"
+#include "hud.c"
+#include "latency.c"
+#include "replay.c"
+#include "rng.c"
+#include "sweep_and_prune.c"
+
+// Asteroids per job batch; below this the update runs inline and never wakes the pool.
+#define ASTEROID_JOB_BATCH_SIZE 512
+
+// Random values behind one asteroid's shape: its scale variance, one scale per vertex and the angular velocity
+#define ASTEROID_RANDOM_VALUE_COUNT (2 + ASTEROID_VERTEX_COUNT)
+// Plus position and velocity when spawning
+#define ASTEROID_SPAWN_RANDOM_VALUE_COUNT (ASTEROID_RANDOM_VALUE_COUNT + 4)
 
 GameState global_state = {};
 
+// Files in SOUND_DIRECTORY, by SoundNames
+static const char *sound_names[SOUND_COUNT] = {"shoot", "explosion", "win", "lose", "power_up_spawned", "power_up_gained"};
+
 f32 SmoothStep(f32 edge0, f32 edge1, f32 x)
 {
     f32 t = Clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
     return t * t * (3.0f - 2.0f * t);
 }
 
-f32 GetRandomFloat01()
-{
-    return (f32)GetRandomValue(0, INT_MAX) / (f32)INT_MAX;
-}
-
-f32 GetRandomFloatRange(f32 min, f32 max)
+Vector2 GetRandomVector2UnitCircle(RandomStream *rng, f32 scale)
 {
-    return min + (max - min) * GetRandomFloat01();
+    f32 angle = NextRandomFloatRange(rng, 0.0f, 2.0f * PI);
+    return (Vector2){cosf(angle) * scale, sinf(angle) * scale};
 }
 
-Vector2 GetRandomVector2UnitCircle(f32 scale)
+static void SeedRandomStreams(GameState *state, u64 seed)
 {
-    f32 x = (GetRandomFloat01() * 2.0f - 1.0f);
-    f32 y = (GetRandomFloat01() * 2.0f - 1.0f);
-    return Vector2Scale(Vector2Normalize((Vector2){x, y}), scale);
+    for (i32 i = 0; i < RANDOM_STREAM_COUNT; ++i) {
+        state->random_streams[i] = CreateRandomStream(seed, i);
+    }
 }
 
 PowerUp *PushPowerUp(PowerUpBuffer *buffer, PowerUp power_up)
@@ -70,12 +92,12 @@ void RemovePowerUp(PowerUpBuffer *buffer, i32 index)
     buffer->count--;
 }
 
-PowerUp CreateRandomPowerUp(Vector2 position)
+PowerUp CreateRandomPowerUp(RandomStream *rng, Vector2 position, f64 time)
 {
     PowerUp power = {
-        .type         = GetRandomValue(0, POWER_UP_TYPE_COUNT - 1),
+        .type         = NextRandomInt(rng, 0, POWER_UP_TYPE_COUNT - 1),
         .position     = position,
-        .time_spawned = GetTime(),
+        .time_spawned = time,
         .radius       = 0.0f,
         .lerp_prog    = 0.0f,
     };
@@ -105,10 +127,12 @@ void RemoveBullet(BulletBuffer *buffer, i32 index)
 Asteroid *PushAsteroid(AsteroidBuffer *buffer, Asteroid asteroid)
 {
     if (buffer->count + 1 > buffer->capacity) {
+        TraceLog(LOG_WARNING, "ASTEROIDS: Buffer full (%d), asteroid dropped; raise ASTEROID_BUFFER_CAPACITY", buffer->capacity);
         return NULL;
     }
 
     buffer->elements[buffer->count] = asteroid;
+    SweepAndPruneAdd(&buffer->sweep, buffer->count);
     return &buffer->elements[buffer->count++];
 }
 
@@ -117,24 +141,147 @@ void RemoveAsteroid(AsteroidBuffer *buffer, i32 index)
     assert(index >= 0);
     assert(index < buffer->count);
 
+    SweepAndPruneRemove(&buffer->sweep, index, buffer->count - 1);
     swap(buffer->elements[index], buffer->elements[buffer->count - 1], Asteroid);
     buffer->count--;
 }
 
-static b32 CheckCollionPlayerLine(Player *player, Vector2 p0, Vector2 p1)
+static void ProjectPolygon(const Vector2 *points, i32 count, Vector2 axis, f32 *min, f32 *max)
 {
-    for (i32 pv = 0; pv < countof(player->vertices); ++pv) {
-        i32     pv_next = (pv + 1) % countof(player->vertices);
-        Vector2 vert0   = Vector2Add(player->vertices[pv], player->position);
-        Vector2 vert1   = Vector2Add(player->vertices[pv_next], player->position);
-        Vector2 collision;
-        if (CheckCollisionLines(p0, p1, vert0, vert1, &collision)) {
-            return true;
+    *min = *max = Vector2DotProduct(points[0], axis);
+    for (i32 i = 1; i < count; ++i) {
+        f32 d = Vector2DotProduct(points[i], axis);
+        *min  = si_min(*min, d);
+        *max  = si_max(*max, d);
+    }
+}
+
+// Separating axis test; both polygons must be convex
+static b32 CheckCollisionConvexPolygons(const Vector2 *a, i32 a_count, const Vector2 *b, i32 b_count)
+{
+    for (i32 shape = 0; shape < 2; ++shape) {
+        const Vector2 *points = (shape == 0) ? a : b;
+        i32            count  = (shape == 0) ? a_count : b_count;
+
+        for (i32 i = 0; i < count; ++i) {
+            Vector2 edge = Vector2Subtract(points[(i + 1) % count], points[i]);
+            Vector2 axis = {-edge.y, edge.x};
+
+            f32 a_min, a_max, b_min, b_max;
+            ProjectPolygon(a, a_count, axis, &a_min, &a_max);
+            ProjectPolygon(b, b_count, axis, &b_min, &b_max);
+            if (a_max < b_min || b_max < a_min) return false;
+        }
+    }
+    return true;
+}
+
+// Separating axis test of a circle against a convex polygon: the edge normals plus the axis to the closest vertex
+static b32 CheckCollisionCircleConvexPolygon(Vector2 center, f32 radius, const Vector2 *points, i32 count)
+{
+    Vector2 closest          = points[0];
+    f32     closest_dist_sqr = FLT_MAX;
+
+    for (i32 i = 0; i <= count; ++i) {
+        Vector2 axis;
+        if (i < count) {
+            Vector2 edge = Vector2Subtract(points[(i + 1) % count], points[i]);
+            axis         = Vector2Normalize((Vector2){-edge.y, edge.x});
+
+            f32 dist_sqr = Vector2DistanceSqr(points[i], center);
+            if (dist_sqr < closest_dist_sqr) {
+                closest_dist_sqr = dist_sqr;
+                closest          = points[i];
+            }
+        } else {
+            axis = Vector2Normalize(Vector2Subtract(center, closest));
+        }
+
+        f32 min, max;
+        ProjectPolygon(points, count, axis, &min, &max);
+        f32 c = Vector2DotProduct(center, axis);
+        if (c + radius < min || c - radius > max) return false;
+    }
+    return true;
+}
+
+// Asteroid shapes are star-shaped around their position, so the fan of (position, v, v + 1) triangles is an exact
+// convex decomposition. The ship is a concave dart and splits into two triangles along its nose/notch diagonal.
+static b32 CheckCollisionPlayerAsteroid(Player *player, Asteroid *asteroid)
+{
+    f32 reach = player->bounding_radius + asteroid->bounding_radius;
+    if (Vector2DistanceSqr(player->position, asteroid->position) > reach * reach) return false;
+
+    Vector2 ship[4];
+    Vector2 ship_min = {FLT_MAX, FLT_MAX};
+    Vector2 ship_max = {-FLT_MAX, -FLT_MAX};
+    for (i32 i = 0; i < countof(ship); ++i) {
+        ship[i]  = Vector2Add(player->vertices[i], player->position);
+        ship_min = (Vector2){si_min(ship_min.x, ship[i].x), si_min(ship_min.y, ship[i].y)};
+        ship_max = (Vector2){si_max(ship_max.x, ship[i].x), si_max(ship_max.y, ship[i].y)};
+    }
+
+    Vector2 ship_parts[2][3] = {
+        {ship[0], ship[1], ship[2]},
+        {ship[0], ship[2], ship[3]},
+    };
+
+    i32 count = countof(asteroid->vertices);
+    for (i32 v = 0; v < count; ++v) {
+        Vector2 piece[3] = {
+            asteroid->position,
+            Vector2Add(asteroid->vertices[v], asteroid->position),
+            Vector2Add(asteroid->vertices[(v + 1) % count], asteroid->position),
+        };
+
+        f32 min_x = si_min(piece[0].x, si_min(piece[1].x, piece[2].x));
+        f32 max_x = si_max(piece[0].x, si_max(piece[1].x, piece[2].x));
+        f32 min_y = si_min(piece[0].y, si_min(piece[1].y, piece[2].y));
+        f32 max_y = si_max(piece[0].y, si_max(piece[1].y, piece[2].y));
+        if (max_x < ship_min.x || min_x > ship_max.x || max_y < ship_min.y || min_y > ship_max.y) continue;
+
+        for (i32 p = 0; p < countof(ship_parts); ++p) {
+            if (CheckCollisionConvexPolygons(piece, countof(piece), ship_parts[p], countof(ship_parts[p]))) {
+                return true;
+            }
         }
     }
     return false;
 }
 
+// Invincibility shield vs asteroid. normal is the outward normal of the touched outer edge closest to the shield's
+// center, so the ship bounces off the surface it hit.
+static b32 CheckCollisionShieldAsteroid(Vector2 center, f32 radius, Asteroid *asteroid, Vector2 *normal)
+{
+    f32 reach = radius + asteroid->bounding_radius;
+    if (Vector2DistanceSqr(center, asteroid->position) > reach * reach) return false;
+
+    b32 hit           = false;
+    f32 best_dist_sqr = FLT_MAX;
+
+    i32 count = countof(asteroid->vertices);
+    for (i32 v = 0; v < count; ++v) {
+        Vector2 piece[3] = {
+            asteroid->position,
+            Vector2Add(asteroid->vertices[v], asteroid->position),
+            Vector2Add(asteroid->vertices[(v + 1) % count], asteroid->position),
+        };
+
+        if (!CheckCollisionCircleConvexPolygon(center, radius, piece, countof(piece))) continue;
+
+        Vector2 tangent  = Vector2Subtract(piece[2], piece[1]);
+        f32     t        = Clamp(Vector2DotProduct(Vector2Subtract(center, piece[1]), tangent) / Vector2LengthSqr(tangent), 0.0f, 1.0f);
+        f32     dist_sqr = Vector2DistanceSqr(center, Vector2Add(piece[1], Vector2Scale(tangent, t)));
+
+        if (dist_sqr < best_dist_sqr) {
+            best_dist_sqr = dist_sqr;
+            *normal       = Vector2Normalize((Vector2){tangent.y, -tangent.x});
+            hit           = true;
+        }
+    }
+    return hit;
+}
+
 static i32 CheckCollisionBulletLine(BulletBuffer *bullets, Vector2 p0, Vector2 p1)
 {
     for (i32 b = 0; b < bullets->count; ++b) {
@@ -157,12 +304,57 @@ static i32 CheckCollisionBulletLine(BulletBuffer *bullets, Vector2 p0, Vector2 p
     return -1;
 }
 
-static void UpdateAsteroidPositions(AsteroidBuffer *asteroid_buffer, f32 min_x, f32 min_y, f32 max_x, f32 max_y, f32 dt)
+// Rotates pairs of vertices at a time: (x0, y0, x1, y1) * cos + (y0, x0, y1, x1) * (-sin, sin, -sin, sin)
+static void RotateVertices(Vector2 *vertices, i32 count, f32 angle)
 {
-    for (i32 i = 0; i < asteroid_buffer->count; ++i) {
+    assert((count & 1) == 0);
+
+    f32   c        = cosf(angle);
+    f32   s        = sinf(angle);
+    f32x4 cos_4    = F32x4Set(c, c, c, c);
+    f32x4 sin_4    = F32x4Set(-s, s, -s, s);
+    f32  *elements = (f32 *)vertices;
+
+    for (i32 i = 0; i < count * 2; i += 4) {
+        f32x4 v = F32x4Load(elements + i);
+        F32x4Store(elements + i, F32x4Add(F32x4Mul(v, cos_4), F32x4Mul(F32x4SwapPairs(v), sin_4)));
+    }
+}
+
+typedef struct AsteroidUpdateJob {
+    AsteroidBuffer *asteroid_buffer;
+    Rectangle       near_view;
+    f32             min_x;
+    f32             min_y;
+    f32             max_x;
+    f32             max_y;
+    f32             dt;
+} AsteroidUpdateJob;
+
+static void UpdateAsteroidPositionRange(void *user_data, i32 begin, i32 end, i32 worker_index)
+{
+    AsteroidUpdateJob *job             = (AsteroidUpdateJob *)user_data;
+    AsteroidBuffer    *asteroid_buffer = job->asteroid_buffer;
+
+    f32 min_x = job->min_x;
+    f32 min_y = job->min_y;
+    f32 max_x = job->max_x;
+    f32 max_y = job->max_y;
+    f32 dt    = job->dt;
+
+    for (i32 i = begin; i < end; ++i) {
         Asteroid *a = &asteroid_buffer->elements[i];
-        a->position.x += a->velocity.x * dt;
-        a->position.y += a->velocity.y * dt;
+
+        // Far away asteroids take coarse steps and skip rotating their vertices until they get near the view
+        b32 near_view = CheckCollisionPointRec(a->position, job->near_view);
+        a->lod_time += dt;
+        if (!near_view && a->lod_time < ASTEROID_LOD_STEP) continue;
+
+        f32 step    = a->lod_time;
+        a->lod_time = 0.0f;
+
+        a->position.x += a->velocity.x * step;
+        a->position.y += a->velocity.y * step;
 
         f32 scale     = asteroid_buffer->asteroid_max_scale / (1.0f + a->generation);
         i32 max_x_off = max_x + scale * 0.9f;
@@ -182,41 +374,181 @@ static void UpdateAsteroidPositions(AsteroidBuffer *asteroid_buffer, f32 min_x,
             a->position.y += max_y_off + scale;
         }
 
-        Matrix mat = MatrixRotateZ(a->angular_velocity * dt);
-        for (i32 v = 0; v < countof(a->vertices); ++v) {
-            a->vertices[v] = Vector2Transform(a->vertices[v], mat);
+        if (near_view) {
+            RotateVertices(a->vertices, countof(a->vertices), a->angular_velocity * step);
         }
     }
 }
 
-static Asteroid CreateAsteroid(Vector2 position, Vector2 velocity, f32 scale, i32 generation)
+static void UpdateAsteroidPositions(
+    JobPool *pool, AsteroidBuffer *asteroid_buffer, Rectangle view, f32 min_x, f32 min_y, f32 max_x, f32 max_y, f32 dt)
+{
+    PROFILE_ZONE("UpdateAsteroidPositions");
+
+    Rectangle near_view = {
+        view.x - ASTEROID_LOD_MARGIN,
+        view.y - ASTEROID_LOD_MARGIN,
+        view.width + 2.0f * ASTEROID_LOD_MARGIN,
+        view.height + 2.0f * ASTEROID_LOD_MARGIN,
+    };
+
+    AsteroidUpdateJob job = {asteroid_buffer, near_view, min_x, min_y, max_x, max_y, dt};
+    RunParallelFor(pool, asteroid_buffer->count, ASTEROID_JOB_BATCH_SIZE, UpdateAsteroidPositionRange, &job);
+}
+
+// random holds ASTEROID_RANDOM_VALUE_COUNT values in [0, 1)
+static Asteroid CreateAsteroidFromRandom(Vector2 position, Vector2 velocity, f32 scale, i32 generation, const f32 *random)
 {
     Asteroid asteroid = {};
 
     i32 count = countof(asteroid.vertices);
     f32 step  = 2 * PI / count;
 
-    f32 scale_variance = GetRandomFloatRange(0.75f, 1.5f);
+    f32 scale_variance = Lerp(0.75f, 1.5f, random[0]);
 
     for (i32 i = 0; i < count; ++i) {
         f32 angle = (i + 1) * step;
         f32 x     = cosf(angle);
         f32 y     = sinf(angle);
-        f32 s     = scale * GetRandomFloatRange(0.4f * scale_variance, 1.0f * scale_variance);
+        f32 s     = scale * Lerp(0.4f * scale_variance, 1.0f * scale_variance, random[1 + i]);
 
         asteroid.vertices[i] = Vector2Scale(Vector2Normalize((Vector2){x, y}), s);
+
+        asteroid.bounding_radius = si_max(asteroid.bounding_radius, s);
+        asteroid.collision_radius += s / count;
     }
 
     asteroid.position         = position;
     asteroid.velocity         = velocity;
     asteroid.generation       = generation;
-    asteroid.angular_velocity = GetRandomFloatRange(-2.0f, 2.0f);
+    asteroid.angular_velocity = Lerp(-2.0f, 2.0f, random[1 + count]);
 
     return asteroid;
 }
 
-static void ExplodeAsteroid(AsteroidBuffer *asteroids, i32 asteroid_id)
+static Asteroid CreateAsteroid(RandomStream *rng, Vector2 position, Vector2 velocity, f32 scale, i32 generation)
+{
+    f32 random[ASTEROID_RANDOM_VALUE_COUNT];
+    NextRandomFloats01(rng, random, countof(random));
+    return CreateAsteroidFromRandom(position, velocity, scale, generation, random);
+}
+
+typedef struct AsteroidSpawnJob {
+    AsteroidBuffer     *asteroid_buffer;
+    const RandomStream *rng;
+    u64                 first_random_index;
+    i32                 first_asteroid;
+    f32                 scale;
+    i32                 generation;
+    Vector2             center;
+    f32                 min_radius;
+    f32                 max_radius;
+    Vector2             world_max;
+} AsteroidSpawnJob;
+
+static void SpawnAsteroidRange(void *user_data, i32 begin, i32 end, i32 worker_index)
+{
+    AsteroidSpawnJob *job = (AsteroidSpawnJob *)user_data;
+
+    // Asteroid i always uses the same values of the stream, so the result doesn't depend on how the range is split
+    f32 random[32 * ASTEROID_SPAWN_RANDOM_VALUE_COUNT];
+    for (i32 chunk_begin = begin; chunk_begin < end; chunk_begin += 32) {
+        i32 chunk_count = si_min(end - chunk_begin, 32);
+        u64 first_index = job->first_random_index + (u64)chunk_begin * ASTEROID_SPAWN_RANDOM_VALUE_COUNT;
+        FillRandomFloat01(job->rng, first_index, chunk_count * ASTEROID_SPAWN_RANDOM_VALUE_COUNT, random);
+
+        for (i32 i = 0; i < chunk_count; ++i) {
+            const f32 *r = &random[i * ASTEROID_SPAWN_RANDOM_VALUE_COUNT];
+
+            Vector2 position;
+            if (job->max_radius > 0.0f) {
+                f32 angle = r[0] * 2.0f * PI;
+                f32 dist  = Lerp(job->min_radius, job->max_radius, r[1]);
+                position  = Vector2Add(job->center, (Vector2){cosf(angle) * dist, sinf(angle) * dist});
+            } else {
+                // Anywhere in the world; anything that lands in the clear area is pushed out to its edge
+                position       = (Vector2){r[0] * job->world_max.x, r[1] * job->world_max.y};
+                Vector2 offset = Vector2Subtract(position, job->center);
+                f32     dist   = Vector2Length(offset);
+                if (dist < job->min_radius) {
+                    Vector2 dir = (dist > 0.0f) ? Vector2Scale(offset, 1.0f / dist) : (Vector2){1.0f, 0.0f};
+                    position    = Vector2Add(job->center, Vector2Scale(dir, job->min_radius));
+                }
+            }
+
+            f32     angle    = r[2] * 2.0f * PI;
+            f32     speed    = Lerp(50.0f, 250.0f, r[3]);
+            Vector2 velocity = {cosf(angle) * speed, sinf(angle) * speed};
+
+            job->asteroid_buffer->elements[job->first_asteroid + chunk_begin + i] =
+                CreateAsteroidFromRandom(position, velocity, job->scale, job->generation, r + 4);
+        }
+    }
+}
+
+// Spawns up to count asteroids in parallel. With max_radius > 0 they go in the ring between min_radius and
+// max_radius around center, otherwise anywhere in [0, world_max] outside min_radius of center.
+// Returns the number spawned; the result is the same for any worker count.
+static i32 SpawnAsteroids(JobPool *pool, AsteroidBuffer *asteroid_buffer, RandomStream *rng, i32 count, f32 scale, i32 generation,
+    Vector2 center, f32 min_radius, f32 max_radius, Vector2 world_max)
+{
+    i32 requested = count;
+    count         = si_min(count, asteroid_buffer->capacity - asteroid_buffer->count);
+    if (count < requested) {
+        TraceLog(LOG_WARNING,
+            "ASTEROIDS: Buffer full (%d), %d of %d asteroids dropped; raise ASTEROID_BUFFER_CAPACITY",
+            asteroid_buffer->capacity,
+            requested - count,
+            requested);
+    }
+    if (count <= 0) return 0;
+
+    AsteroidSpawnJob job = {
+        .asteroid_buffer    = asteroid_buffer,
+        .rng                = rng,
+        .first_random_index = ReserveRandomValues(rng, (u64)count * ASTEROID_SPAWN_RANDOM_VALUE_COUNT),
+        .first_asteroid     = asteroid_buffer->count,
+        .scale              = scale,
+        .generation         = generation,
+        .center             = center,
+        .min_radius         = min_radius,
+        .max_radius         = max_radius,
+        .world_max          = world_max,
+    };
+    RunParallelFor(pool, count, ASTEROID_JOB_BATCH_SIZE / 4, SpawnAsteroidRange, &job);
+
+    for (i32 i = 0; i < count; ++i) {
+        SweepAndPruneAdd(&asteroid_buffer->sweep, asteroid_buffer->count++);
+    }
+    return count;
+}
+
+static Player CreatePlayer(Vector2 position)
 {
+    f32 player_width  = 48.0f;
+    f32 player_height = 64.0f;
+
+    Player player = {};
+
+    player.height                = player_height;
+    player.position              = position;
+    player.reference_vertices[0] = (Vector2){0.0f, -player_height / 2.0f};
+    player.reference_vertices[1] = (Vector2){player_width / 2.0f, player_height / 2.0f};
+    player.reference_vertices[2] = (Vector2){0.0f, player_height / 8.0f};
+    player.reference_vertices[3] = (Vector2){-player_width / 2.0f, player_height / 2.0f};
+    memcpy(player.vertices, player.reference_vertices, sizeof(player.vertices));
+
+    for (i32 i = 0; i < countof(player.reference_vertices); ++i) {
+        player.bounding_radius = si_max(player.bounding_radius, Vector2Length(player.reference_vertices[i]));
+    }
+
+    return player;
+}
+
+static void ExplodeAsteroid(AsteroidBuffer *asteroids, RandomStream *rng, i32 asteroid_id)
+{
+    PROFILE_ZONE("ExplodeAsteroid");
+
     Asteroid *a = &asteroids->elements[asteroid_id];
 
     Vector2 position   = a->position;
@@ -232,13 +564,91 @@ static void ExplodeAsteroid(AsteroidBuffer *asteroids, i32 asteroid_id)
         Vector2 p0 = Vector2Add(position, split_dir);
         Vector2 p1 = Vector2Add(position, Vector2Negate(split_dir));
 
-        PushAsteroid(asteroids, CreateAsteroid(p0, velocity, scale, generation + 1));
-        PushAsteroid(asteroids, CreateAsteroid(p1, Vector2Negate(velocity), scale, generation + 1));
+        PushAsteroid(asteroids, CreateAsteroid(rng, p0, velocity, scale, generation + 1));
+        PushAsteroid(asteroids, CreateAsteroid(rng, p1, Vector2Negate(velocity), scale, generation + 1));
     }
 }
 
-static void UpdateBulletLives(BulletBuffer *bullets, Vector2 world_min, Vector2 world_max)
+// Mass follows area, and every generation halves the asteroid's scale
+static f32 GetAsteroidMass(i32 generation)
+{
+    f32 relative_scale = 1.0f / (f32)(1 << generation);
+    return relative_scale * relative_scale;
+}
+
+static void ResolveAsteroidCollision(void *user_data, i32 a_index, i32 b_index)
 {
+    AsteroidBuffer *asteroids = (AsteroidBuffer *)user_data;
+    Asteroid       *a         = &asteroids->elements[a_index];
+    Asteroid       *b         = &asteroids->elements[b_index];
+
+    Vector2 delta    = Vector2Subtract(b->position, a->position);
+    f32     min_dist = a->collision_radius + b->collision_radius;
+    f32     dist_sqr = Vector2LengthSqr(delta);
+    if (dist_sqr >= min_dist * min_dist) return;
+    asteroids->contact_count++;
+
+    f32     dist   = sqrtf(dist_sqr);
+    Vector2 normal = (dist > 0.0f) ? Vector2Scale(delta, 1.0f / dist) : (Vector2){1.0f, 0.0f};
+
+    f32 inv_mass_a = 1.0f / GetAsteroidMass(a->generation);
+    f32 inv_mass_b = 1.0f / GetAsteroidMass(b->generation);
+    f32 inv_mass   = inv_mass_a + inv_mass_b;
+
+    // Push the pair apart so they don't stay interlocked, lighter asteroids move further
+    Vector2 correction = Vector2Scale(normal, (min_dist - dist) / inv_mass);
+    a->position        = Vector2Subtract(a->position, Vector2Scale(correction, inv_mass_a));
+    b->position        = Vector2Add(b->position, Vector2Scale(correction, inv_mass_b));
+
+    f32 approach_speed = Vector2DotProduct(Vector2Subtract(b->velocity, a->velocity), normal);
+    if (approach_speed >= 0.0f) return;
+
+    // Elastic impulse along the contact normal
+    f32 impulse = -2.0f * approach_speed / inv_mass;
+    a->velocity = Vector2Subtract(a->velocity, Vector2Scale(normal, impulse * inv_mass_a));
+    b->velocity = Vector2Add(b->velocity, Vector2Scale(normal, impulse * inv_mass_b));
+}
+
+static void UpdateAsteroidCollisions(AsteroidBuffer *asteroids)
+{
+    PROFILE_ZONE("UpdateAsteroidCollisions");
+
+    asteroids->contact_count = 0;
+    UpdateSweepAndPrune(&asteroids->sweep, asteroids->elements, asteroids->count);
+    FindSweepAndPrunePairs(&asteroids->sweep, asteroids->elements, ResolveAsteroidCollision, asteroids);
+}
+
+static b32 IsCircleInView(Rectangle view, Vector2 center, f32 radius)
+{
+    return center.x + radius >= view.x && center.x - radius <= view.x + view.width && center.y + radius >= view.y &&
+           center.y - radius <= view.y + view.height;
+}
+
+// Keeps the player in the middle of the screen, without showing anything past the world edges
+static void UpdateFollowCamera(GameState *state)
+{
+    Camera2D *camera = &state->camera;
+
+    // NOTE: assumes aspect ratio will not change
+    camera->zoom   = state->screen_width / (f32)VIEW_WIDTH;
+    camera->offset = (Vector2){state->screen_width / 2.0f, state->screen_height / 2.0f};
+
+    Vector2 half_view = Vector2Scale(camera->offset, 1.0f / camera->zoom);
+    Vector2 min       = Vector2Add(state->world_min, half_view);
+    Vector2 max       = Vector2Subtract(state->world_max, half_view);
+
+    camera->target.x = (min.x < max.x) ? Clamp(state->player.position.x, min.x, max.x) : (min.x + max.x) / 2.0f;
+    camera->target.y = (min.y < max.y) ? Clamp(state->player.position.y, min.y, max.y) : (min.y + max.y) / 2.0f;
+
+    state->view = (Rectangle){camera->target.x - half_view.x, camera->target.y - half_view.y, half_view.x * 2.0f, half_view.y * 2.0f};
+}
+
+// Bullets die once they leave the view (or the world, whichever is smaller)
+static void UpdateBulletLives(BulletBuffer *bullets, Vector2 world_min, Vector2 world_max, Rectangle view)
+{
+    world_min = Vector2Clamp(world_min, (Vector2){view.x, view.y}, (Vector2){view.x + view.width, view.y + view.height});
+    world_max = Vector2Clamp(world_max, (Vector2){view.x, view.y}, (Vector2){view.x + view.width, view.y + view.height});
+
     for (i32 i = 0; i < bullets->count; ++i) {
         Bullet *b = &bullets->elements[i];
         if ((b->position.y > world_max.y || b->position.y < world_min.y || b->position.x > world_max.x || b->position.x < world_min.x)) {
@@ -254,60 +664,49 @@ static void InitializeGame(GameState *state)
 
     state->game_over = false;
     state->game_won  = false;
+    state->paused    = false;
 
     state->screen_width  = GetScreenWidth();
     state->screen_height = GetScreenHeight();
 
     if (!state->resources_loaded) {
-        state->sounds[SOUND_SHOOT]            = LoadSound("sounds/shoot.wav");
-        state->sounds[SOUND_EXPLOSION]        = LoadSound("sounds/explosion.wav");
-        state->sounds[SOUND_WIN]              = LoadSound("sounds/win.wav");
-        state->sounds[SOUND_LOSE]             = LoadSound("sounds/lose.wav");
-        state->sounds[SOUND_POWER_UP_SPAWNED] = LoadSound("sounds/power_up_spawned.wav");
-        state->sounds[SOUND_POWER_UP_GAINED]  = LoadSound("sounds/power_up_gained.wav");
+        SoundLoadStats sound_stats = LoadGameSounds(&state->job_pool, state->sounds, sound_names, SOUND_COUNT);
+        ReportSoundLoad(sound_stats, SOUND_COUNT);
 
-        InitializeBloomEffect(&state->bloom, state->screen_width, state->screen_height);
+        InitializeBloomEffect(&state->bloom, state->screen_width, state->screen_height, state->target_formats[RENDER_PASS_BLOOM]);
 
 #if defined(PLATFORM_WEB)
         state->fxaa_shader = LoadShader(NULL, "shaders/fxaa_300_es.frag");
 #else
         state->fxaa_shader = LoadShader(NULL, "shaders/fxaa.frag");
 #endif
+        // NOTE: render_targets[i] belongs to pass RENDER_PASS_SCENE + i
         for (i32 i = 0; i < countof(state->render_targets); ++i) {
-            state->render_targets[i] = LoadRenderTexture(state->screen_width, state->screen_height);
+            RenderTargetFormat *format = &state->target_formats[RENDER_PASS_SCENE + i];
+            state->render_targets[i]   = LoadRenderTargetWithFormat(state->screen_width, state->screen_height, format);
             SetTextureFilter(state->render_targets[i].texture, TEXTURE_FILTER_BILINEAR);
         }
 
+        state->frame_cache = LoadRenderTexture(state->screen_width, state->screen_height);
+        InitializeHud(&state->hud);
+
         state->resources_loaded = true;
     }
 
-    SetSoundVolume(state->sounds[SOUND_EXPLOSION], 0.5f);
-    f32 player_width  = 48.0f;
-    f32 player_height = 64.0f;
-
-    state->player = (Player){};
-
-    state->player.height                = player_height;
-    state->player.reference_vertices[0] = (Vector2){0.0f, -player_height / 2.0f};
-    state->player.reference_vertices[1] = (Vector2){player_width / 2.0f, player_height / 2.0f};
-    state->player.reference_vertices[2] = (Vector2){0.0f, player_height / 8.0f};
-    state->player.reference_vertices[3] = (Vector2){-player_width / 2.0f, player_height / 2.0f};
-    memcpy(state->player.vertices, state->player.reference_vertices, sizeof(state->player.vertices));
-
-    state->player.position = (Vector2){state->world_max.x / 2.0f, state->world_max.y / 2.0f};
+    SetGameSoundVolume(&state->sounds[SOUND_EXPLOSION], 0.5f);
+    state->player = CreatePlayer((Vector2){state->world_max.x / 2.0f, state->world_max.y / 2.0f});
 
     state->player.shooting_rate      = 0.25f;
-    state->player.shooting_timestamp = GetTime();
+    state->player.shooting_timestamp = state->time;
 
-    // NOTE: assumes aspect ratio will not change
-    state->camera.zoom = state->screen_width / 2560.0f;
+    UpdateFollowCamera(state);
 
-    state->asteroid_buffer = (AsteroidBuffer){
-        .count              = 0,
-        .elements           = {},
-        .capacity           = countof(state->asteroid_buffer.elements),
-        .asteroid_max_scale = 128.0f,
-    };
+    // NOTE: Not a compound literal; with a large ASTEROID_BUFFER_CAPACITY that would build a multi-megabyte
+    // temporary on the stack, which the default web stack cannot hold.
+    state->asteroid_buffer.count              = 0;
+    state->asteroid_buffer.capacity           = countof(state->asteroid_buffer.elements);
+    state->asteroid_buffer.asteroid_max_scale = 128.0f;
+    ResetSweepAndPrune(&state->asteroid_buffer.sweep);
 
     state->bullet_buffer = (BulletBuffer){
         .count    = 0,
@@ -321,20 +720,40 @@ static void InitializeGame(GameState *state)
         .capacity = countof(state->power_up_buffer.elements),
     };
 
-    for (i32 i = 0; i < 24; ++i) {
-        Vector2 screen_center = (Vector2){(f32)state->world_max.x / 2, (f32)state->world_max.y / 2};
-        Vector2 random_dir    = GetRandomVector2UnitCircle(GetRandomFloatRange(state->world_max.y / 4.0f, state->world_max.y / 1.25f));
-        Vector2 position      = Vector2Add(screen_center, random_dir);
-        Vector2 velocity      = GetRandomVector2UnitCircle(GetRandomFloatRange(50.0f, 250.0f));
-        PushAsteroid(&state->asteroid_buffer, CreateAsteroid(position, velocity, state->asteroid_buffer.asteroid_max_scale, 0));
+    // A large world is filled evenly, keeping the player's starting area clear; a single view gets a ring around the player
+    Vector2 screen_center = (Vector2){(f32)state->world_max.x / 2, (f32)state->world_max.y / 2};
+    f32     min_radius    = (WORLD_SCALE > 1) ? VIEW_HEIGHT / 4.0f : state->world_max.y / 4.0f;
+    f32     max_radius    = (WORLD_SCALE > 1) ? 0.0f : state->world_max.y / 1.25f;
+    SpawnAsteroids(&state->job_pool,
+        &state->asteroid_buffer,
+        &state->random_streams[RANDOM_STREAM_ASTEROIDS],
+        ASTEROIDS_PER_VIEW * WORLD_SCALE * WORLD_SCALE,
+        state->asteroid_buffer.asteroid_max_scale,
+        0,
+        screen_center,
+        min_radius,
+        max_radius,
+        state->world_max);
+}
+
+// Points the ship at target
+static void OrientPlayer(Player *player, Vector2 target)
+{
+    f32    angle = Vector2Angle((Vector2){0.0f, -1.0f}, Vector2Subtract(target, player->position));
+    Matrix rot   = MatrixRotateZ(angle);
+    for (i32 i = 0; i < countof(player->vertices); ++i) {
+        player->vertices[i] = Vector2Transform(player->reference_vertices[i], rot);
     }
 }
 
-static void Update(GameState *state)
+static void Update(GameState *state, const FrameInput *input)
 {
-    f32 dt = GetFrameTime();
+    PROFILE_ZONE("Update");
 
-    Vector2 mouse_pos = Vector2Scale(GetMousePosition(), 1.0f / state->camera.zoom);
+    f32 dt = input->dt;
+    state->time += dt;
+
+    Vector2 mouse_pos = GetScreenToWorld2D(input->mouse_position, state->camera);
 
     i32 screen_width  = GetScreenWidth();
     i32 screen_height = GetScreenHeight();
@@ -343,15 +762,25 @@ static void Update(GameState *state)
     state->screen_height = screen_height;
 
     if (state->game_over || state->game_won) {
-        if (IsKeyPressed(KEY_SPACE)) {
+        if (input->flags & INPUT_RESTART) {
             InitializeGame(state);
         }
         return;
     }
 
+    if (input->flags & INPUT_PAUSE) {
+        state->paused = !state->paused;
+    } else if (input->flags & INPUT_FOCUS_LOST) {
+        state->paused = true;
+    }
+
+    if (state->paused) {
+        return;
+    }
+
     if (state->asteroid_buffer.count == 0) {
         state->game_won = true;
-        PlaySound(state->sounds[SOUND_WIN]);
+        PlayGameSound(&state->sounds[SOUND_WIN]);
         return;
     }
 
@@ -363,37 +792,33 @@ static void Update(GameState *state)
 
         if (Vector2Distance(p->position, state->player.position) <= POWER_UP_RADIUS) {
             state->player.power_up_flags |= 1 << p->type;
-            state->player.power_up_timestamps[p->type] = GetTime();
-            PlaySound(state->sounds[SOUND_POWER_UP_GAINED]);
+            state->player.power_up_timestamps[p->type] = state->time;
+            PlayGameSound(&state->sounds[SOUND_POWER_UP_GAINED]);
             RemovePowerUp(&state->power_up_buffer, i--);
         }
     }
 
     for (i32 i = 0; i < countof(state->player.power_up_timestamps); i++) {
-        if (GetTime() - state->player.power_up_timestamps[i] >= POWER_UP_DURATION) {
+        if (state->time - state->player.power_up_timestamps[i] >= POWER_UP_DURATION) {
             state->player.power_up_flags &= ~(1u << i);
         }
     }
 
-    UpdateBulletLives(&state->bullet_buffer, state->world_min, state->world_max);
+    UpdateBulletLives(&state->bullet_buffer, state->world_min, state->world_max, state->view);
 
-    f32    angle = Vector2Angle((Vector2){0.0f, -1.0f}, Vector2Subtract(mouse_pos, state->player.position));
-    Matrix rot   = MatrixRotateZ(angle);
-    for (i32 i = 0; i < countof(state->player.vertices); ++i) {
-        state->player.vertices[i] = Vector2Transform(state->player.reference_vertices[i], rot);
-    }
+    OrientPlayer(&state->player, mouse_pos);
 
-    if (IsKeyPressed(KEY_F)) {
+    if (input->flags & INPUT_TOGGLE_FPS) {
         state->show_fps = !state->show_fps;
     }
 
-    if (IsKeyDown(KEY_SPACE) || IsMouseButtonDown(0)) {
+    if (input->flags & INPUT_FIRE) {
         f32 shooting_rate =
             ((state->player.power_up_flags >> POWER_UP_TYPE_MACHINE_GUN) & 1) ? (PLAYER_SHOOTING_RATE * 0.5f) : PLAYER_SHOOTING_RATE;
 
-        if (GetTime() - state->player.shooting_timestamp >= shooting_rate) {
-            SetSoundPitch(state->sounds[SOUND_SHOOT], GetRandomFloatRange(0.95f, 1.05f));
-            PlaySound(state->sounds[SOUND_SHOOT]);
+        if (state->time - state->player.shooting_timestamp >= shooting_rate) {
+            SetGameSoundPitch(&state->sounds[SOUND_SHOOT], NextRandomFloatRange(&state->random_streams[RANDOM_STREAM_SOUND], 0.95f, 1.05f));
+            PlayGameSound(&state->sounds[SOUND_SHOOT]);
             Vector2 direction = Vector2Normalize(Vector2Subtract(mouse_pos, state->player.position));
             Vector2 pos       = Vector2Add(state->player.position, Vector2Scale(direction, state->player.height / 2.0f));
 
@@ -421,15 +846,15 @@ static void Update(GameState *state)
                 PushBullet(&state->bullet_buffer, bullet);
             }
 
-            state->player.shooting_timestamp = GetTime();
+            state->player.shooting_timestamp = state->time;
         }
     }
 
     Vector2 direction = {};
-    if (IsKeyDown(KEY_W) || IsKeyDown(KEY_UP)) direction = Vector2Add(direction, (Vector2){0.0f, -1.0f});
-    if (IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN)) direction = Vector2Add(direction, (Vector2){0.0f, 1.0f});
-    if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT)) direction = Vector2Add(direction, (Vector2){-1.0f, 0.0f});
-    if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) direction = Vector2Add(direction, (Vector2){1.0f, 0.0f});
+    if (input->flags & INPUT_UP) direction = Vector2Add(direction, (Vector2){0.0f, -1.0f});
+    if (input->flags & INPUT_DOWN) direction = Vector2Add(direction, (Vector2){0.0f, 1.0f});
+    if (input->flags & INPUT_LEFT) direction = Vector2Add(direction, (Vector2){-1.0f, 0.0f});
+    if (input->flags & INPUT_RIGHT) direction = Vector2Add(direction, (Vector2){1.0f, 0.0f});
     direction              = Vector2Normalize(direction);
     state->player.velocity = Vector2Add(state->player.velocity, Vector2Scale(direction, 2.0f * dt));
 
@@ -467,49 +892,77 @@ static void Update(GameState *state)
         b->position      = Vector2Add(b->position, Vector2Scale(b->velocity, dt));
     }
 
-    UpdateAsteroidPositions(&state->asteroid_buffer, 0, 0, state->world_max.x, state->world_max.y, dt);
+    UpdateFollowCamera(state);
+
+    UpdateAsteroidPositions(&state->job_pool, &state->asteroid_buffer, state->view, 0, 0, state->world_max.x, state->world_max.y, dt);
+    UpdateAsteroidCollisions(&state->asteroid_buffer);
 
     //============ Player/Asteroid and Bullet/Asteroid collision checks ===============
-    Asteroid *asteroids = state->asteroid_buffer.elements;
+    PROFILE_ZONE("player and bullet collisions");
+
+    Asteroid *asteroids   = state->asteroid_buffer.elements;
+    b32       invincible  = (state->player.power_up_flags >> POWER_UP_TYPE_INVINCIBILITY) & 1;
+    i32       bullet_hits = 0;
+
+    // NOTE: Bullets die at the edge of the view, so in a large world most asteroids are nowhere near any of them.
+    // Their swept paths are boxed once here and only the asteroids that touch the box get the per-edge tests.
+    Vector2 bullets_min = {FLT_MAX, FLT_MAX};
+    Vector2 bullets_max = {-FLT_MAX, -FLT_MAX};
+    for (i32 b = 0; b < state->bullet_buffer.count; ++b) {
+        Bullet *bullet = &state->bullet_buffer.elements[b];
+        bullets_min.x  = fminf(bullets_min.x, fminf(bullet->position.x, bullet->prev_position.x) - bullet->radius);
+        bullets_min.y  = fminf(bullets_min.y, fminf(bullet->position.y, bullet->prev_position.y) - bullet->radius);
+        bullets_max.x  = fmaxf(bullets_max.x, fmaxf(bullet->position.x, bullet->prev_position.x) + bullet->radius);
+        bullets_max.y  = fmaxf(bullets_max.y, fmaxf(bullet->position.y, bullet->prev_position.y) + bullet->radius);
+    }
+
     for (i32 i = 0; i < state->asteroid_buffer.count; ++i) {
 
+        if (invincible) {
+            Vector2 normal = {};
+            if (CheckCollisionShieldAsteroid(state->player.position, state->player.height - 16, &asteroids[i], &normal)) {
+                // state->player.velocity = Vector2Reflect(state->player.velocity, normal);
+                state->player.velocity = Vector2Scale(normal, Vector2Length(state->player.velocity));
+            }
+        } else if (!state->game_over && CheckCollisionPlayerAsteroid(&state->player, &asteroids[i])) {
+            state->game_over = true;
+            PlayGameSound(&state->sounds[SOUND_LOSE]);
+            continue;
+        }
+
+        Vector2 center = asteroids[i].position;
+        f32     reach  = asteroids[i].bounding_radius;
+        if (center.x + reach < bullets_min.x || center.x - reach > bullets_max.x || center.y + reach < bullets_min.y ||
+            center.y - reach > bullets_max.y) {
+            continue;
+        }
+
         for (i32 v = 0; v < countof(asteroids[i].vertices); ++v) {
             i32     next = (v + 1) % countof(asteroids[i].vertices);
             Vector2 pos0 = Vector2Add(asteroids[i].vertices[v], asteroids[i].position);
             Vector2 pos1 = Vector2Add(asteroids[i].vertices[next], asteroids[i].position);
 
-            if ((state->player.power_up_flags >> POWER_UP_TYPE_INVINCIBILITY) & 1) {
-                // if (true) {
-                if (CheckCollisionCircleLine(state->player.position, state->player.height - 16, pos0, pos1)) {
-                    Vector2 tangent = Vector2Subtract(pos1, pos0);
-                    Vector3 normal =
-                        Vector3Normalize(Vector3CrossProduct((Vector3){0.0f, 0.0f, -1.0f}, (Vector3){tangent.x, tangent.y, 0.0f}));
-                    // state->player.velocity = Vector2Reflect(state->player.velocity, (Vector2){normal.x, normal.y});
-                    state->player.velocity = Vector2Scale((Vector2){normal.x, normal.y}, Vector2Length(state->player.velocity));
-                }
-            } else if (CheckCollionPlayerLine(&state->player, pos0, pos1)) {
-                state->game_over = true;
-                PlaySound(state->sounds[SOUND_LOSE]);
-                break;
-            }
-
             i32 bullet_id = CheckCollisionBulletLine(&state->bullet_buffer, pos0, pos1);
 
             if (bullet_id >= 0) {
-                SetSoundPitch(state->sounds[SOUND_EXPLOSION], GetRandomFloatRange(0.90f, 1.1f));
-                PlaySound(state->sounds[SOUND_EXPLOSION]);
+                bullet_hits++;
+
+                f32 pitch = NextRandomFloatRange(&state->random_streams[RANDOM_STREAM_SOUND], 0.90f, 1.1f);
+                SetGameSoundPitch(&state->sounds[SOUND_EXPLOSION], pitch);
+                PlayGameSound(&state->sounds[SOUND_EXPLOSION]);
 
                 state->player.score += POINTS_PER_ASTEROID / (asteroids[i].generation + 1);
 
-                if (GetRandomValue(0, 25) == 0) {
+                RandomStream *power_up_rng = &state->random_streams[RANDOM_STREAM_POWER_UPS];
+                if (NextRandomInt(power_up_rng, 0, 25) == 0) {
                     Vector2 padding = {50.0f, 50.0f};
                     Vector2 clamped = Vector2Clamp(
                         asteroids[i].position, Vector2Add(state->world_min, padding), Vector2Subtract(state->world_max, padding));
-                    PushPowerUp(&state->power_up_buffer, CreateRandomPowerUp(clamped));
-                    PlaySound(state->sounds[SOUND_POWER_UP_SPAWNED]);
+                    PushPowerUp(&state->power_up_buffer, CreateRandomPowerUp(power_up_rng, clamped, state->time));
+                    PlayGameSound(&state->sounds[SOUND_POWER_UP_SPAWNED]);
                 }
 
-                ExplodeAsteroid(&state->asteroid_buffer, i--);
+                ExplodeAsteroid(&state->asteroid_buffer, &state->random_streams[RANDOM_STREAM_ASTEROIDS], i--);
 
                 if (((state->player.power_up_flags >> POWER_UP_TYPE_BOUNCEY_BULLETS) & 1) == 0) {
                     RemoveBullet(&state->bullet_buffer, bullet_id);
@@ -518,35 +971,96 @@ static void Update(GameState *state)
             }
         }
     }
+
+    PROFILE_COUNTER("asteroids", state->asteroid_buffer.count);
+    PROFILE_COUNTER("bullets", state->bullet_buffer.count);
+    PROFILE_COUNTER("broadphase pair tests", state->asteroid_buffer.sweep.pair_tests);
+    PROFILE_COUNTER("asteroid contacts", state->asteroid_buffer.contact_count);
+    PROFILE_COUNTER("bullet hits", bullet_hits);
 }
 
-static void Draw(GameState *state)
+// Every how many vertices an outline level keeps (0 for a quad) and the smallest on-screen bounding radius, in pixels,
+// it is drawn at
+static const i32 outline_lod_strides[ASTEROID_OUTLINE_LOD_COUNT]   = {1, 2, 3, 0};
+static const f32 outline_lod_min_radii[ASTEROID_OUTLINE_LOD_COUNT] = {32.0f, 16.0f, 6.0f, 0.0f};
+
+static i32 SelectOutlineLod(i32 lod, f32 screen_radius)
 {
+    f32 grow   = 1.0f + ASTEROID_OUTLINE_LOD_HYSTERESIS;
+    f32 shrink = 1.0f - ASTEROID_OUTLINE_LOD_HYSTERESIS;
+    while (lod > 0 && screen_radius > outline_lod_min_radii[lod - 1] * grow) lod--;
+    while (lod < ASTEROID_OUTLINE_LOD_COUNT - 1 && screen_radius < outline_lod_min_radii[lod] * shrink) lod++;
+    return lod;
+}
+
+// Collision always uses the full shape, only the drawing is reduced
+static void DrawAsteroidOutline(Asteroid *asteroid, i32 lod)
+{
+    i32 stride = outline_lod_strides[lod];
+    if (stride == 0) {
+        // NOTE: A square as bright as the outline would be, 3 units wide around the collision radius
+        f32 size = sqrtf(2.0f * PI * asteroid->collision_radius * 3.0f);
+        DrawRectangleV(Vector2SubtractValue(asteroid->position, size / 2.0f), (Vector2){size, size}, WHITE);
+        return;
+    }
+
+    i32 count = countof(asteroid->vertices);
+    for (i32 v = 0; v < count; v += stride) {
+        i32     next = (v + stride < count) ? v + stride : 0;
+        Vector2 pos0 = Vector2Add(asteroid->vertices[v], asteroid->position);
+        Vector2 pos1 = Vector2Add(asteroid->vertices[next], asteroid->position);
+        DrawLineEx(pos0, pos1, 3.0f, WHITE);
+    }
+}
+
+// Marks where a bright circle of the world lands on the bloom tiles
+static void MarkBloomCircle(GameState *state, Vector2 center, f32 radius)
+{
+    Vector2 screen = GetWorldToScreen2D(center, state->camera);
+    f32     r      = radius * state->camera.zoom + BLOOM_TILE_MARGIN;
+    MarkBloomTiles(&state->bloom, (Rectangle){screen.x - r, screen.y - r, 2.0f * r, 2.0f * r});
+}
+
+static void DrawScene(GameState *state)
+{
+    PROFILE_ZONE("DrawScene");
+
+    // Everything drawn below glows, so it marks the tiles bloom has to run on
+    ResetBloomTiles(&state->bloom);
+
     //====== Draw Geometry Into a Render Teture =========
     BeginTextureMode(state->render_targets[0]);
     ClearBackground(BLACK);
     BeginMode2D(state->camera);
 
+    // With an HDR target overlapping shapes add up past 1 and the bloom tonemap keeps them as highlights
+    b32 hdr = state->target_formats[RENDER_PASS_SCENE] != RENDER_TARGET_FORMAT_RGBA8;
+    if (hdr) BeginBlendMode(BLEND_ADDITIVE);
+
+    memset(state->outline_lod_counts, 0, sizeof(state->outline_lod_counts));
+
     Asteroid *asteroids = state->asteroid_buffer.elements;
     for (i32 i = 0; i < state->asteroid_buffer.count; ++i) {
-        for (i32 v = 0; v < countof(asteroids[i].vertices); ++v) {
-            i32     next = (v + 1) % countof(asteroids[i].vertices);
-            Vector2 pos0 = Vector2Add(asteroids[i].vertices[v], asteroids[i].position);
-            Vector2 pos1 = Vector2Add(asteroids[i].vertices[next], asteroids[i].position);
-            DrawLineEx(pos0, pos1, 3.0f, WHITE);
-        }
+        if (!IsCircleInView(state->view, asteroids[i].position, asteroids[i].bounding_radius + 3.0f)) continue;
+        MarkBloomCircle(state, asteroids[i].position, asteroids[i].bounding_radius + 3.0f);
+
+        asteroids[i].outline_lod = SelectOutlineLod(asteroids[i].outline_lod, asteroids[i].bounding_radius * state->camera.zoom);
+        state->outline_lod_counts[asteroids[i].outline_lod]++;
+        DrawAsteroidOutline(&asteroids[i], asteroids[i].outline_lod);
     }
 
     for (i32 i = 0; i < state->power_up_buffer.count; ++i) {
         PowerUp *p   = &state->power_up_buffer.elements[i];
         Vector2  pos = p->position;
+        if (!IsCircleInView(state->view, pos, p->radius + 6.0f)) continue;
+        MarkBloomCircle(state, pos, p->radius + 6.0f);
         // DrawCircleGradient(pos.x, pos.y, POWER_UP_RADIUS, BLACK, Fade(BLUE, 0.5f));
         f32     r = p->radius;
         Vector2 v[3];
         for (i32 i = 0; i < countof(v); ++i) {
             f32 angle = (2.0f * PI / countof(v)) * (f32)(i + 1);
-            f32 x     = cosf(angle + GetTime() * 2) * r;
-            f32 y     = sinf(angle + GetTime() * 2) * r;
+            f32 x     = cosf(angle + state->time * 2) * r;
+            f32 y     = sinf(angle + state->time * 2) * r;
             v[i]      = (Vector2){x + pos.x, y + pos.y};
         }
         Color colors[POWER_UP_TYPE_COUNT] = {BLUE, GOLD, GREEN, RED};
@@ -556,22 +1070,25 @@ static void Draw(GameState *state)
         DrawLineEx(v[2], v[0], 6.0f, colors[p->type]);
 
         // DrawTriangle(t0, t1, t2, Fade(GOLD, 0.5f));
-        char letters[POWER_UP_TYPE_COUNT] = {'B', 'I', 'S', 'M'};
-
         i32 font_size = p->radius - 20;
-        DrawText(TextFormat("%c", letters[p->type]), pos.x - p->radius / 2 + 20, pos.y - p->radius / 2 + 20, font_size, WHITE);
+        DrawPowerUpLetter(&state->hud, p->type, pos.x - p->radius / 2 + 20, pos.y - p->radius / 2 + 20, font_size);
     }
 
     for (i32 i = 0; i < state->bullet_buffer.count; ++i) {
         Vector2 pos = state->bullet_buffer.elements[i].position;
+        if (!IsCircleInView(state->view, pos, state->bullet_buffer.elements[i].radius)) continue;
+        MarkBloomCircle(state, pos, state->bullet_buffer.elements[i].radius);
         DrawCircle(pos.x, pos.y, state->bullet_buffer.elements[i].radius, YELLOW);
     }
 
+    // NOTE: Covers the invincibility glow too
+    MarkBloomCircle(state, state->player.position, state->player.height);
     if ((state->player.power_up_flags >> POWER_UP_TYPE_INVINCIBILITY) & 1) {
         DrawCircleGradient(
             state->player.position.x, state->player.position.y, state->player.height - 16, Fade(BLACK, 0.0f), Fade(ORANGE, 0.5f));
     }
 
+    memcpy(state->drawn_player_vertices, state->player.vertices, sizeof(state->drawn_player_vertices));
     for (i32 i = 0; i < countof(state->player.vertices); ++i) {
         i32     next = (i + 1) % countof(state->player.vertices);
         Vector2 pos0 = Vector2Add(state->player.vertices[i], state->player.position);
@@ -579,29 +1096,38 @@ static void Draw(GameState *state)
         DrawLineEx(pos0, pos1, 3.0f, ORANGE);
     }
 
+    if (hdr) EndBlendMode();
     EndMode2D();
 
     // Draw score before bloom to give it glow effect
-    {
-        i32 font_size = 36;
-        DrawText(TextFormat("SCORE: %d", state->player.score), 10, state->screen_height - font_size - 10, font_size, GRAY);
-    }
+    DrawHudScore(&state->hud, 10, state->screen_height - 10);
+    MarkBloomTiles(&state->bloom,
+        (Rectangle){10 - BLOOM_TILE_MARGIN,
+            state->screen_height - 10 - HUD_SCORE_TARGET_HEIGHT - BLOOM_TILE_MARGIN,
+            HUD_SCORE_TARGET_WIDTH + 2 * BLOOM_TILE_MARGIN,
+            HUD_SCORE_TARGET_HEIGHT + 2 * BLOOM_TILE_MARGIN});
 
     EndTextureMode();
 
-    BeginShaderMode(state->fxaa_shader);
-    i32 loc = GetShaderLocation(state->fxaa_shader, "resolution");
-    SetShaderValue(state->fxaa_shader,
-        loc,
-        (float[2]){state->render_targets[0].texture.width, state->render_targets[0].texture.height},
-        SHADER_UNIFORM_VEC2);
-    DrawFramebuffer(state->render_targets[0], state->render_targets[1], true);
-    EndShaderMode();
+    {
+        PROFILE_ZONE("FXAA");
+        BeginShaderMode(state->fxaa_shader);
+        i32 loc = GetShaderLocation(state->fxaa_shader, "resolution");
+        SetShaderValue(state->fxaa_shader,
+            loc,
+            (float[2]){state->render_targets[0].texture.width, state->render_targets[0].texture.height},
+            SHADER_UNIFORM_VEC2);
+        DrawFramebuffer(state->render_targets[0], state->render_targets[1], true);
+        EndShaderMode();
+    }
 
     RenderBloomTextures(state);
+}
 
-    //==== Draw to backbuffer using bloom =====
-    BeginDrawing();
+// Composes the scene and its bloom textures into the currently bound framebuffer
+static void DrawComposite(GameState *state)
+{
+    PROFILE_ZONE("DrawComposite");
 
     BloomScreenEffect *bloom = &state->bloom;
     BeginShaderMode(bloom->bloom_shader);
@@ -616,17 +1142,20 @@ static void Draw(GameState *state)
         0.0f,
         WHITE);
     EndShaderMode();
+}
 
-    //======= Draw UI =========
+static void DrawOverlay(GameState *state)
+{
+    PROFILE_ZONE("DrawOverlay");
 
-    if (state->game_over || state->game_won) {
+    if (state->game_over || state->game_won || state->paused) {
         Rectangle rect = {state->screen_width / 2.0f - 256.0f, state->screen_height / 2.0f - 128.0f, 512.0f, 256.0f};
         DrawRectangleRounded(rect, 0.3f, 6, Fade(DARKGRAY, 0.5f));
 
-        Color color = (state->game_over) ? RED : GREEN;
+        Color color = (state->game_over) ? RED : (state->game_won) ? GREEN : WHITE;
 
-        const char *status_str     = (state->game_over) ? "GAME OVER!" : "YOU WIN!";
-        const char *start_over_str = "PRESS SPACE TO START OVER";
+        const char *status_str     = (state->game_over) ? "GAME OVER!" : (state->game_won) ? "YOU WIN!" : "PAUSED";
+        const char *start_over_str = (state->paused) ? "PRESS P TO RESUME" : "PRESS SPACE TO START OVER";
 
         i32 font_size  = 42;
         i32 text_width = MeasureText(status_str, font_size);
@@ -644,43 +1173,351 @@ static void Draw(GameState *state)
 
     if (state->show_fps) {
         DrawFPS(10, 10);
+        DrawText(TextFormat("BLOOM %d%%", (i32)(state->bloom.coverage * 100.0f + 0.5f)), 10, 34, 20, LIME);
+
+        i32 *lods = state->outline_lod_counts;
+        DrawText(TextFormat("LOD %d/%d/%d/%d", lods[0], lods[1], lods[2], lods[3]), 10, 58, 20, LIME);
     }
+}
+
+static void DrawFullscreenTexture(Texture2D texture)
+{
+    DrawTexturePro(texture,
+        (Rectangle){0, 0, (float)texture.width, (float)-texture.height},
+        (Rectangle){0, 0, (float)texture.width, (float)-texture.height},
+        (Vector2){0, 0},
+        0.0f,
+        WHITE);
+}
+
+// The composed scene (or the cached one on static screens) with the UI on top
+static void DrawFrame(GameState *state)
+{
+    if (state->static_screen) {
+        DrawFullscreenTexture(state->frame_cache.texture);
+    } else {
+        DrawComposite(state);
+        state->frame_cache_valid = false;
+    }
+
+    //======= Draw UI =========
+    DrawOverlay(state);
+}
+
+static void Draw(GameState *state)
+{
+    PROFILE_ZONE("Draw");
+
+    UpdateHud(&state->hud, state->player.score);
+
+    // The drawn ship turns towards where the mouse is now rather than where it was at the frame's poll. Collisions and
+    // replays keep the orientation Update gave it.
+    Vector2 simulated_vertices[countof(state->player.vertices)];
+    b32     late_latch = state->late_latch && !state->game_over && !state->game_won && !state->paused;
+    if (late_latch) {
+        Vector2 mouse_position = ReadLatestMousePosition();
+        LatchLatencyAim(&state->latency, mouse_position, GetTime());
+
+        memcpy(simulated_vertices, state->player.vertices, sizeof(simulated_vertices));
+        OrientPlayer(&state->player, GetScreenToWorld2D(mouse_position, state->camera));
+    }
+
+    // Nothing moves on static screens, so the post-process chain only runs once when entering one
+    if (!state->static_screen || !state->frame_cache_valid) {
+        DrawScene(state);
+    }
+
+    if (late_latch) {
+        memcpy(state->player.vertices, simulated_vertices, sizeof(simulated_vertices));
+    }
+
+    if (state->static_screen && !state->frame_cache_valid) {
+        BeginTextureMode(state->frame_cache);
+        DrawComposite(state);
+        EndTextureMode();
+        state->frame_cache_valid = true;
+    }
+
+    // While capturing, the frame is composed off screen and read back from there, then shown
+    if (state->capture.active) {
+        BeginTextureMode(state->capture.target);
+        ClearBackground(BLACK);
+        DrawFrame(state);
+        EndTextureMode();
+
+        PROFILE_ZONE("CaptureFrame");
+        CaptureFrame(&state->capture);
+    }
+
+    //==== Draw to backbuffer using bloom =====
+    BeginDrawing();
+
+    if (state->capture.active) {
+        DrawFullscreenTexture(state->capture.target.texture);
+    } else {
+        DrawFrame(state);
+    }
+
+#if !defined(ASTEROIDS_CUSTOM_FRAME_CONTROL)
+    EndLatencyFrame(&state->latency);
+#endif
+
+    // NOTE: Includes the swap and, without custom frame control, raylib's wait for the next frame
+    PROFILE_ZONE("EndDrawing");
     EndDrawing();
 }
 
+static void SetFrameRate(GameState *state, i32 fps)
+{
+#if defined(PLATFORM_WEB)
+    if (fps > 0) {
+        emscripten_set_main_loop_timing(EM_TIMING_SETTIMEOUT, 1000 / fps);
+    } else {
+        emscripten_set_main_loop_timing(EM_TIMING_RAF, 1);
+    }
+#elif defined(ASTEROIDS_CUSTOM_FRAME_CONTROL)
+    state->frame_scheduler.period = (fps > 0) ? 1.0 / fps : 0.0;
+#else
+    SetTargetFPS(fps);
+#endif
+}
+
+// Drops to STATIC_SCREEN_FPS while nothing on screen changes, to save battery and GPU time. Captures keep the full
+// frame rate so the video timing stays constant.
+static void UpdateFrameRate(GameState *state)
+{
+    b32 static_screen = (state->game_over || state->game_won || state->paused) && !state->capture.active;
+    if (static_screen == state->static_screen) return;
+
+    state->static_screen = static_screen;
+    SetFrameRate(state, static_screen ? STATIC_SCREEN_FPS : state->target_fps);
+}
+
+// F9 toggles recording the screen to a Y4M file
+static void ToggleCapture(GameState *state)
+{
+    if (state->capture.active) {
+        StopCapture(&state->capture);
+        return;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "capture_%lld.y4m", (long long)time(NULL));
+    StartCapture(&state->capture, state->screen_width, state->screen_height, state->target_fps, CAPTURE_FORMAT_Y4M, path, false);
+}
+
+// F8 switches the late latch while measuring latency, logging what was measured with the previous setting
+static void ToggleLateLatch(GameState *state)
+{
+    ReportLatency(&state->latency, state->late_latch ? "(late latch)" : "(no late latch)");
+    state->late_latch = !state->late_latch;
+}
+
 void UpdateAndDraw()
 {
-    Update(&global_state);
+#if defined(ASTEROIDS_CUSTOM_FRAME_CONTROL)
+    BeginScheduledFrame(&global_state.frame_scheduler);
+#endif
+
+    FrameInput input = ReadFrameInput();
+#if defined(ASTEROIDS_CUSTOM_FRAME_CONTROL)
+    // NOTE: raylib only times frames when EndDrawing swaps
+    input.dt = global_state.frame_scheduler.frame_time;
+#endif
+    BeginLatencyFrame(&global_state.latency, &input, GetTime());
+
+    if (global_state.recording) {
+        RecordFrameInput(&global_state.replay, input);
+    }
+
+    if (IsKeyPressed(KEY_F9)) {
+        ToggleCapture(&global_state);
+    }
+
+    if (global_state.latency.active && IsKeyPressed(KEY_F8)) {
+        ToggleLateLatch(&global_state);
+    }
+
+#if defined(ASTEROIDS_PROFILE)
+    if (IsKeyPressed(KEY_F7)) {
+        DumpProfileTrace();
+    }
+#endif
+
+    Update(&global_state, &input);
+    UpdateGameSounds(global_state.sounds, SOUND_COUNT);
+    UpdateFrameRate(&global_state);
     Draw(&global_state);
+
+#if defined(ASTEROIDS_CUSTOM_FRAME_CONTROL)
+    EndScheduledFrame(&global_state.frame_scheduler);
+    EndLatencyFrame(&global_state.latency);
+#endif
+}
+
+static void UnloadGame(GameState *state)
+{
+    StopCapture(&state->capture);
+
+    for (i32 i = 0; i < countof(state->sounds); ++i) {
+        UnloadGameSound(&state->sounds[i]);
+    }
+
+    for (i32 i = 0; i < countof(state->render_targets); ++i) {
+        UnloadRenderTexture(state->render_targets[i]);
+    }
+    UnloadRenderTexture(state->frame_cache);
+    UnloadHud(&state->hud);
+    UnloadBloomEffect(&state->bloom);
+    UnloadJobPool(&state->job_pool);
+    UnloadReplay(&state->replay);
+}
+
+#if !defined(ASTEROIDS_HEADLESS)
+// Plays a recorded session back through the full renderer in a hidden window, without a frame limit, and
+// captures every frame. The window takes the recorded size since the view (and so the simulation LOD) depends on it.
+static b32 RenderReplay(GameState *state, const char *replay_path, const char *output_path, CaptureFormat format)
+{
+    if (!LoadReplay(&state->replay, replay_path)) {
+        TraceLog(LOG_ERROR, "REPLAY: Could not load %s", replay_path);
+        return false;
+    }
+    ReplayHeader header = state->replay.header;
+
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(header.screen_width, header.screen_height, "Asteroids");
+    SetTargetFPS(0);
+    SeedRandomStreams(state, header.seed);
+    InitializeJobPool(&state->job_pool, -1);
+
+    InitializeGame(state);
+    state->target_fps = header.fps;
+    ReportRenderTargets(state);
+
+    b32 ok = StartCapture(&state->capture, state->screen_width, state->screen_height, header.fps, format, output_path, true);
+
+    // NOTE: The late latch would aim the ship at wherever the cursor is while rendering, the replay has to show the
+    // recorded aim
+    state->late_latch = false;
+
+    f64        start     = GetTime();
+    f64        play_time = 0.0;
+    FrameInput input;
+    while (ok && NextReplayFrame(&state->replay, &input)) {
+        Update(state, &input);
+        Draw(state);
+        play_time += input.dt;
+
+        if (memcmp(state->drawn_player_vertices, state->player.vertices, sizeof(state->drawn_player_vertices)) != 0) {
+            TraceLog(LOG_ERROR, "REPLAY: Frame %d drew the ship away from where the simulation put it", state->replay.cursor);
+            ok = false;
+        }
+    }
+    StopCapture(&state->capture);
+
+    TraceLog(LOG_INFO,
+        "REPLAY: %d frames, %.1f s of play rendered in %.1f s",
+        state->replay.cursor,
+        play_time,
+        GetTime() - start);
+
+    UnloadGame(state);
+    CloseWindow();
+    return ok;
 }
 
-int main(void)
+// usage: asteroids [--record session.rec] [--<pass>-format <format>] [--latency] [--no-late-latch]
+//        asteroids --render session.rec [--out replay.y4m] [--png] [--<pass>-format <format>]
+// with <pass> one of scene, fxaa, bloom and <format> one of rgba8, r11g11b10f, rgba16f
+int main(int argc, char **argv)
 {
+    const char   *record_path = NULL;
+    const char   *render_path = NULL;
+    const char   *output_path = NULL;
+    CaptureFormat format      = CAPTURE_FORMAT_Y4M;
+    b32           latency     = false;
+
+    global_state.late_latch = true;
+
+    for (i32 i = 0; i < RENDER_PASS_COUNT; ++i) {
+        global_state.target_formats[i] = DEFAULT_RENDER_TARGET_FORMAT;
+    }
+
+    for (i32 i = 1; i < argc; ++i) {
+        i32 pass = -1;
+        for (i32 p = 0; p < RENDER_PASS_COUNT; ++p) {
+            if (strcmp(argv[i], TextFormat("--%s-format", render_pass_names[p])) == 0) pass = p;
+        }
+
+        if (pass >= 0 && i + 1 < argc) {
+            i32 target_format = ParseRenderTargetFormat(argv[++i]);
+            if (target_format >= 0) global_state.target_formats[pass] = target_format;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--render") == 0 && i + 1 < argc) {
+            render_path = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "--png") == 0) {
+            format = CAPTURE_FORMAT_PNG;
+        } else if (strcmp(argv[i], "--latency") == 0) {
+            latency = true;
+        } else if (strcmp(argv[i], "--no-late-latch") == 0) {
+            global_state.late_latch = false;
+        }
+    }
+
+    if (render_path) {
+        if (!output_path) output_path = (format == CAPTURE_FORMAT_Y4M) ? "replay.y4m" : "replay";
+        return RenderReplay(&global_state, render_path, output_path, format) ? 0 : 1;
+    }
+
+    PROFILE_THREAD_NAME("main", -1);
     InitWindow(STARTING_WINDOW_WIDTH, STARTING_WINDOW_HEIGHT, "Asteroids");
     InitAudioDevice();
-    SetRandomSeed(time(NULL));
+
+    u64 seed = (u64)time(NULL);
+    SeedRandomStreams(&global_state, seed);
+    InitializeJobPool(&global_state.job_pool, -1);
 
     InitializeGame(&global_state);
+    global_state.target_fps = GetMonitorRefreshRate(GetCurrentMonitor());
+    ReportRenderTargets(&global_state);
+
+    // NOTE: Measuring waits for the GPU to finish every frame, which itself costs some frame rate
+    global_state.latency.active = latency && LoadGLFunctions();
+
+    if (record_path) {
+        BeginReplayRecording(&global_state.replay, seed, global_state.screen_width, global_state.screen_height, global_state.target_fps);
+        global_state.recording = true;
+    }
 
 #if defined(PLATFORM_WEB)
-    emscripten_set_main_loop(UpdateAndDraw, GetMonitorRefreshRate(GetCurrentMonitor()), 1);
+    emscripten_set_main_loop(UpdateAndDraw, global_state.target_fps, 1);
 #else
-    SetTargetFPS(GetMonitorRefreshRate(GetCurrentMonitor()));
+#if defined(ASTEROIDS_CUSTOM_FRAME_CONTROL)
+    InitializeFrameScheduler(&global_state.frame_scheduler, global_state.target_fps);
+#else
+    SetTargetFPS(global_state.target_fps);
     // SetTargetFPS(0);
+#endif
     while (!WindowShouldClose()) {
         UpdateAndDraw();
     }
 #endif
 
-    for (i32 i = 0; i < countof(global_state.sounds); ++i) {
-        UnloadSound(global_state.sounds[i]);
-    }
+    ReportLatency(&global_state.latency, global_state.late_latch ? "(late latch)" : "(no late latch)");
+#if defined(ASTEROIDS_PROFILE)
+    DumpProfileTrace();
+#endif
 
-    for (i32 i = 0; i < countof(global_state.render_targets); ++i) {
-        UnloadRenderTexture(global_state.render_targets[i]);
+    if (record_path && !SaveReplay(&global_state.replay, record_path)) {
+        TraceLog(LOG_WARNING, "REPLAY: Could not save %s", record_path);
     }
-    UnloadBloomEffect(&global_state.bloom);
+
+    UnloadGame(&global_state);
 
     CloseAudioDevice();
     CloseWindow();
 }
+#endif
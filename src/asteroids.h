@@ -18,13 +18,25 @@
 #define si_max(a, b) (a) > (b) ? (a) : (b)
 
 #define POINTS_PER_ASTEROID 150
+#define ASTEROID_VERTEX_COUNT 12
+
+// Stress/benchmark builds raise this (e.g. -DASTEROID_BUFFER_CAPACITY=16384).
+#ifndef ASTEROID_BUFFER_CAPACITY
+#define ASTEROID_BUFFER_CAPACITY 128
+#endif
+
+#include "sweep_and_prune.h"
 
 typedef struct Asteroid {
     Vector2 position;
     Vector2 velocity;
     f32     angular_velocity;
-    i32     generation; // 3 generations. 0 = Big asteroid, 1 = Medium, 2 = Small, >=3 = dead
-    Vector2 vertices[12];
+    i32     generation;       // 3 generations. 0 = Big asteroid, 1 = Medium, 2 = Small, >=3 = dead
+    f32     bounding_radius;  // Furthest vertex, used by the broadphase
+    f32     collision_radius; // Average vertex distance, used for asteroid/asteroid contacts
+    f32     lod_time;         // Time not yet integrated while far from the view
+    i32     outline_lod;      // Detail its outline was last drawn at, only used for drawing
+    Vector2 vertices[ASTEROID_VERTEX_COUNT];
 } Asteroid;
 
 enum PowerUpType {
@@ -48,6 +60,7 @@ typedef struct Player {
     i32     score;
     f32     rotation;
     f32     height;
+    f32     bounding_radius;
     f32     shooting_rate;
     f32     shooting_timestamp;
 
@@ -90,6 +103,9 @@ typedef struct AsteroidBuffer {
     i32      capacity;
     i32      count;
     f32      asteroid_max_scale;
-    Asteroid elements[128];
+    i32      contact_count; // Asteroid pairs found touching by the last collision update
+    Asteroid elements[ASTEROID_BUFFER_CAPACITY];
+
+    SweepAndPrune sweep;
 } AsteroidBuffer;
 #endif // ASTEROIDS_HEADER_GUARD
@@ -0,0 +1,160 @@
+#include "audio.h"
+#include "../include/raylib.h"
+#include "jobs.h"
+#include "types.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+// Samples per channel in one QOA frame, the unit raylib's music streams decode at a time
+#define QOA_FRAME_SAMPLES 5120
+
+typedef struct SoundLoadJob {
+    u8  **files;
+    i32  *file_sizes;
+    Wave *waves;
+} SoundLoadJob;
+
+// Length in seconds from the file header and the first frame header, without reading or decoding the rest
+static f32 ReadQoaDuration(const char *path)
+{
+    u8    header[12] = {};
+    FILE *file       = fopen(path, "rb");
+    if (!file) return 0.0f;
+    size_t read = fread(header, 1, sizeof(header), file);
+    fclose(file);
+
+    if (read < sizeof(header) || memcmp(header, "qoaf", 4) != 0) return 0.0f;
+    u32 samples     = (u32)header[4] << 24 | (u32)header[5] << 16 | (u32)header[6] << 8 | header[7];
+    u32 sample_rate = (u32)header[9] << 16 | (u32)header[10] << 8 | header[11];
+    return (sample_rate > 0) ? (f32)samples / sample_rate : 0.0f;
+}
+
+static void DecodeSoundRange(void *user_data, i32 begin, i32 end, i32 worker_index)
+{
+    SoundLoadJob *job = user_data;
+    for (i32 i = begin; i < end; ++i) {
+        if (job->files[i]) {
+            job->waves[i] = LoadWaveFromMemory(SOUND_FILE_EXTENSION, job->files[i], job->file_sizes[i]);
+        }
+    }
+}
+
+// Loads SOUND_DIRECTORY/<name>.qoa for every name. The files are read on the calling thread and decoded in parallel
+// on the job pool, then handed to the audio device on the calling thread again.
+static SoundLoadStats LoadGameSounds(JobPool *pool, GameSound *sounds, const char **names, i32 count)
+{
+    assert(count <= SOUND_LOAD_MAX);
+    SoundLoadStats stats = {};
+    f64            start = GetTime();
+
+    // NOTE: The workers don't touch files: on the web, file access from a worker is proxied to the main thread,
+    // which is busy waiting for them here
+    char paths[SOUND_LOAD_MAX][128];
+    u8  *files[SOUND_LOAD_MAX]      = {};
+    i32  file_sizes[SOUND_LOAD_MAX] = {};
+    Wave waves[SOUND_LOAD_MAX]      = {};
+    for (i32 i = 0; i < count; ++i) {
+        snprintf(paths[i], sizeof(paths[i]), "%s/%s%s", SOUND_DIRECTORY, names[i], SOUND_FILE_EXTENSION);
+        sounds[i] = (GameSound){.streamed = ReadQoaDuration(paths[i]) > SOUND_STREAM_MIN_SECONDS};
+        if (!sounds[i].streamed) {
+            files[i] = LoadFileData(paths[i], &file_sizes[i]);
+        }
+    }
+
+    SoundLoadJob job = {.files = files, .file_sizes = file_sizes, .waves = waves};
+    RunParallelFor(pool, count, 1, DecodeSoundRange, &job);
+
+    for (i32 i = 0; i < count; ++i) {
+        // NOTE: raylib converts decoded sounds to the device format (32-bit float stereo), while streams keep two
+        // small buffers in the file's format plus the frame being decoded
+        if (sounds[i].streamed) {
+            sounds[i].music         = LoadMusicStream(paths[i]);
+            sounds[i].music.looping = false;
+
+            AudioStream stream = sounds[i].music.stream;
+
+            stats.file_bytes     += GetFileLength(paths[i]);
+            stats.resident_bytes += (i64)(stream.sampleRate / 30 * 2 + QOA_FRAME_SAMPLES) * stream.channels * sizeof(i16);
+        } else {
+            sounds[i].sound = LoadSoundFromWave(waves[i]);
+            UnloadWave(waves[i]);
+            UnloadFileData(files[i]);
+
+            stats.file_bytes     += file_sizes[i];
+            stats.resident_bytes += (i64)sounds[i].sound.frameCount * 2 * sizeof(f32);
+        }
+
+        char source_path[128];
+        snprintf(source_path, sizeof(source_path), "%s/%s.wav", SOUND_DIRECTORY, names[i]);
+        if (FileExists(source_path)) stats.source_bytes += GetFileLength(source_path);
+    }
+
+    stats.load_time = GetTime() - start;
+    return stats;
+}
+
+static void ReportSoundLoad(SoundLoadStats stats, i32 count)
+{
+    TraceLog(LOG_INFO,
+        "AUDIO: %d sounds, %.1f KB of qoa, %.1f KB resident, loaded in %.2f ms",
+        count,
+        stats.file_bytes / 1024.0,
+        stats.resident_bytes / 1024.0,
+        stats.load_time * 1000.0);
+    if (stats.source_bytes > 0) {
+        TraceLog(LOG_INFO,
+            "AUDIO: %.1f KB as wav, %.1f%% saved",
+            stats.source_bytes / 1024.0,
+            100.0 * (1.0 - (f64)stats.file_bytes / stats.source_bytes));
+    }
+}
+
+static void UnloadGameSound(GameSound *sound)
+{
+    if (sound->streamed) {
+        UnloadMusicStream(sound->music);
+    } else {
+        UnloadSound(sound->sound);
+    }
+}
+
+// Restarts the sound if it is already playing
+static void PlayGameSound(GameSound *sound)
+{
+    if (sound->streamed) {
+        StopMusicStream(sound->music);
+        PlayMusicStream(sound->music);
+    } else {
+        PlaySound(sound->sound);
+    }
+}
+
+static void SetGameSoundPitch(GameSound *sound, f32 pitch)
+{
+    if (sound->streamed) {
+        SetMusicPitch(sound->music, pitch);
+    } else {
+        SetSoundPitch(sound->sound, pitch);
+    }
+}
+
+static void SetGameSoundVolume(GameSound *sound, f32 volume)
+{
+    if (sound->streamed) {
+        SetMusicVolume(sound->music, volume);
+    } else {
+        SetSoundVolume(sound->sound, volume);
+    }
+}
+
+// Refills the buffers of the streams that are playing, once per frame
+static void UpdateGameSounds(GameSound *sounds, i32 count)
+{
+    for (i32 i = 0; i < count; ++i) {
+        if (sounds[i].streamed && IsMusicStreamPlaying(sounds[i].music)) {
+            UpdateMusicStream(sounds[i].music);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef AUDIO_HEADER_GUARD
+#define AUDIO_HEADER_GUARD
+
+#include "../include/raylib.h"
+#include "types.h"
+
+// Sounds ship as QOA (see convert_sounds.c), about a fifth the size of the 16-bit WAVs they are made from
+#define SOUND_DIRECTORY "sounds"
+#define SOUND_FILE_EXTENSION ".qoa"
+
+// Sounds longer than this are streamed while they play instead of being decoded up front. Decoded sounds are held
+// as 32-bit float stereo by the audio device, about 350 KB per second of audio.
+#define SOUND_STREAM_MIN_SECONDS 4.0f
+
+#define SOUND_LOAD_MAX 32
+
+typedef struct GameSound {
+    b32   streamed;
+    Sound sound; // Decoded
+    Music music; // Streamed: an AudioStream whose buffers are refilled from the file as they play out
+} GameSound;
+
+typedef struct SoundLoadStats {
+    i64 file_bytes;     // QOA files as shipped
+    i64 source_bytes;   // The WAVs they were converted from, 0 where those aren't around (e.g. on the web)
+    i64 resident_bytes; // Decoded sounds and stream buffers
+    f64 load_time;
+} SoundLoadStats;
+
+#endif // AUDIO_HEADER_GUARD
@@ -0,0 +1,231 @@
+/**************************************************************************
+    Headless simulation benchmark. Builds the game as a unity build without
+    main() and steps the asteroid simulation with no window, audio or GPU,
+    so the same binary can run natively or under Node for the web builds.
+
+    usage: bench [asteroid_count] [ticks] [worker_count]
+           bench narrowphase [scenario_count]
+***************************************************************************/
+
+#define ASTEROIDS_HEADLESS
+#ifndef ASTEROID_BUFFER_CAPACITY
+#define ASTEROID_BUFFER_CAPACITY 16384
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "asteroids.c"
+#include "clock.c"
+
+static void SpawnBenchAsteroids(GameState *state, i32 count)
+{
+    // Grow the world with the asteroid count so the density (and so the contact count) stays close to a real game
+    f32 world_scale  = si_max(1.0f, sqrtf(count / 64.0f));
+    state->world_min = (Vector2){0.0f, 0.0f};
+    state->world_max = (Vector2){WORLD_WIDTH * world_scale, WORLD_HEIGHT * world_scale};
+
+    state->asteroid_buffer.count              = 0;
+    state->asteroid_buffer.capacity           = countof(state->asteroid_buffer.elements);
+    state->asteroid_buffer.asteroid_max_scale = 128.0f;
+    ResetSweepAndPrune(&state->asteroid_buffer.sweep);
+
+    // One screen's worth of view in the middle of the world, like the follow camera in a large world
+    state->view = (Rectangle){(state->world_max.x - VIEW_WIDTH) / 2.0f, (state->world_max.y - VIEW_HEIGHT) / 2.0f, VIEW_WIDTH, VIEW_HEIGHT};
+
+    // A third of each generation, spread over the whole world
+    RandomStream *rng = &state->random_streams[RANDOM_STREAM_ASTEROIDS];
+    for (i32 gen = 0; gen < 3; ++gen) {
+        i32 gen_count = count / 3 + (gen < count % 3);
+        f32 scale     = state->asteroid_buffer.asteroid_max_scale / (gen + 1);
+        SpawnAsteroids(&state->job_pool, &state->asteroid_buffer, rng, gen_count, scale, gen, state->world_min, 0.0f, 0.0f, state->world_max);
+    }
+}
+
+// FNV-1a over the spawned asteroids, to check the spawn is identical for every worker count
+static u32 HashAsteroids(AsteroidBuffer *asteroid_buffer)
+{
+    u32       hash  = 2166136261u;
+    const u8 *bytes = (const u8 *)asteroid_buffer->elements;
+    for (size_t i = 0; i < sizeof(Asteroid) * asteroid_buffer->count; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void StepBenchSimulation(GameState *state, f32 dt)
+{
+    UpdateAsteroidPositions(&state->job_pool, &state->asteroid_buffer, state->view, 0, 0, state->world_max.x, state->world_max.y, dt);
+    UpdateAsteroidCollisions(&state->asteroid_buffer);
+}
+
+// The player/asteroid test the game used before the SAT narrowphase: every asteroid edge against every ship edge
+static b32 CheckCollisionPlayerAsteroidLegacy(Player *player, Asteroid *asteroid)
+{
+    for (i32 v = 0; v < countof(asteroid->vertices); ++v) {
+        i32     next = (v + 1) % countof(asteroid->vertices);
+        Vector2 p0   = Vector2Add(asteroid->vertices[v], asteroid->position);
+        Vector2 p1   = Vector2Add(asteroid->vertices[next], asteroid->position);
+
+        for (i32 pv = 0; pv < countof(player->vertices); ++pv) {
+            i32     pv_next = (pv + 1) % countof(player->vertices);
+            Vector2 vert0   = Vector2Add(player->vertices[pv], player->position);
+            Vector2 vert1   = Vector2Add(player->vertices[pv_next], player->position);
+            Vector2 collision;
+            if (CheckCollisionLines(p0, p1, vert0, vert1, &collision)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static b32 IsPointInAsteroid(Vector2 point, Asteroid *asteroid)
+{
+    b32 inside = false;
+    i32 count  = countof(asteroid->vertices);
+    for (i32 i = 0, j = count - 1; i < count; j = i++) {
+        Vector2 a = Vector2Add(asteroid->vertices[i], asteroid->position);
+        Vector2 b = Vector2Add(asteroid->vertices[j], asteroid->position);
+        if ((a.y > point.y) != (b.y > point.y) && point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+typedef struct NarrowphaseScenario {
+    Asteroid asteroid;
+    Player   player;
+} NarrowphaseScenario;
+
+// Compares the SAT narrowphase against the legacy edge/edge test on a seeded set of player/asteroid placements.
+// The only expected disagreements are ships entirely inside an asteroid, which the edge test cannot see.
+static void RunNarrowphaseBench(i32 scenario_count)
+{
+    NarrowphaseScenario *scenarios = malloc(sizeof(NarrowphaseScenario) * scenario_count);
+    b32                 *legacy    = malloc(sizeof(b32) * scenario_count);
+    b32                 *sat       = malloc(sizeof(b32) * scenario_count);
+
+    RandomStream base          = CreateRandomStream(4321, 0);
+    RandomStream asteroid_rng  = SplitRandomStream(&base, 0);
+    RandomStream placement_rng = SplitRandomStream(&base, 1);
+    for (i32 i = 0; i < scenario_count; ++i) {
+        NarrowphaseScenario *s = &scenarios[i];
+
+        i32 generation = NextRandomInt(&placement_rng, 0, 2);
+        s->asteroid = CreateAsteroid(&asteroid_rng, (Vector2){0.0f, 0.0f}, (Vector2){0.0f, 0.0f}, 128.0f / (1 << generation), generation);
+        RotateVertices(s->asteroid.vertices, countof(s->asteroid.vertices), NextRandomFloatRange(&placement_rng, 0.0f, 2.0f * PI));
+
+        // Mostly near misses and grazes, like the pairs that survive a broadphase, plus some clear misses
+        f32     reach    = s->asteroid.bounding_radius + 40.0f;
+        Vector2 position = {
+            NextRandomFloatRange(&placement_rng, -1.5f * reach, 1.5f * reach), NextRandomFloatRange(&placement_rng, -1.5f * reach, 1.5f * reach)};
+        Matrix rot = MatrixRotateZ(NextRandomFloatRange(&placement_rng, 0.0f, 2.0f * PI));
+
+        s->player = CreatePlayer(position);
+        for (i32 v = 0; v < countof(s->player.vertices); ++v) {
+            s->player.vertices[v] = Vector2Transform(s->player.reference_vertices[v], rot);
+        }
+    }
+
+    const i32 repeats = 10;
+
+    f64 start = GetMonotonicTime();
+    for (i32 r = 0; r < repeats; ++r) {
+        for (i32 i = 0; i < scenario_count; ++i) {
+            legacy[i] = CheckCollisionPlayerAsteroidLegacy(&scenarios[i].player, &scenarios[i].asteroid);
+        }
+    }
+    f64 legacy_time = GetMonotonicTime() - start;
+
+    start = GetMonotonicTime();
+    for (i32 r = 0; r < repeats; ++r) {
+        for (i32 i = 0; i < scenario_count; ++i) {
+            sat[i] = CheckCollisionPlayerAsteroid(&scenarios[i].player, &scenarios[i].asteroid);
+        }
+    }
+    f64 sat_time = GetMonotonicTime() - start;
+
+    i32 hits       = 0;
+    i32 contained  = 0;
+    i32 mismatches = 0;
+    for (i32 i = 0; i < scenario_count; ++i) {
+        hits += sat[i];
+        if (legacy[i] == sat[i]) continue;
+
+        b32 inside = sat[i];
+        for (i32 v = 0; v < countof(scenarios[i].player.vertices); ++v) {
+            Vector2 p = Vector2Add(scenarios[i].player.vertices[v], scenarios[i].player.position);
+            inside    = inside && IsPointInAsteroid(p, &scenarios[i].asteroid);
+        }
+
+        if (inside) {
+            contained++;
+        } else {
+            mismatches++;
+        }
+    }
+
+    printf("scenarios: %d, hits: %d, ship inside asteroid (missed by legacy): %d, mismatches: %d\n",
+        scenario_count,
+        hits,
+        contained,
+        mismatches);
+    printf("legacy: %.1f ns/test, sat: %.1f ns/test\n",
+        legacy_time * 1.0e9 / ((f64)scenario_count * repeats),
+        sat_time * 1.0e9 / ((f64)scenario_count * repeats));
+
+    free(scenarios);
+    free(legacy);
+    free(sat);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "narrowphase") == 0) {
+        RunNarrowphaseBench((argc > 2) ? atoi(argv[2]) : 100000);
+        return 0;
+    }
+
+    i32 asteroid_count = (argc > 1) ? atoi(argv[1]) : 10000;
+    i32 ticks          = (argc > 2) ? atoi(argv[2]) : 1000;
+    i32 worker_count   = (argc > 3) ? atoi(argv[3]) : -1;
+
+    GameState *state = &global_state;
+    SeedRandomStreams(state, 1234);
+    InitializeJobPool(&state->job_pool, worker_count);
+
+    f64 spawn_start = GetMonotonicTime();
+    SpawnBenchAsteroids(state, asteroid_count);
+    f64 spawn_time = GetMonotonicTime() - spawn_start;
+    u32 spawn_hash = HashAsteroids(&state->asteroid_buffer);
+
+    const f32 dt = 1.0f / 60.0f;
+
+    // Warm up caches and (on the web) give pool workers a chance to come online.
+    for (i32 i = 0; i < 30; ++i) {
+        StepBenchSimulation(state, dt);
+    }
+
+    f64 start = GetMonotonicTime();
+    for (i32 i = 0; i < ticks; ++i) {
+        StepBenchSimulation(state, dt);
+    }
+    f64 elapsed = GetMonotonicTime() - start;
+
+    printf("simd: %s, workers: %d, asteroids: %d, ticks: %d\n",
+        SIMD_ENABLED ? "yes" : "no",
+        state->job_pool.worker_count,
+        state->asteroid_buffer.count,
+        ticks);
+    printf("%.3f ms/tick, %.2f M asteroid updates/s, %d broadphase pair tests in the last tick\n",
+        elapsed * 1000.0 / ticks,
+        (f64)state->asteroid_buffer.count * ticks / elapsed / 1.0e6,
+        state->asteroid_buffer.sweep.pair_tests);
+    printf("spawn: %.3f ms, checksum %08x\n", spawn_time * 1000.0, spawn_hash);
+
+    UnloadJobPool(&state->job_pool);
+    return 0;
+}
@@ -1,11 +1,15 @@
 #include "bloom.h"
 #include "../include/raylib.h"
 #include "asteroids.h"
+#include "profile.h"
 #include "types.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "game.h"
 
-static void InitializeBloomEffect(BloomScreenEffect *bloom, i32 start_width, i32 start_height)
+static void InitializeBloomEffect(BloomScreenEffect *bloom, i32 start_width, i32 start_height, RenderTargetFormat format)
 {
 #if defined(PLATFORM_WEB)
     bloom->blur_shader  = LoadShader(NULL, "shaders/gaussian_blur_300_es.frag");
@@ -15,11 +19,12 @@ static void InitializeBloomEffect(BloomScreenEffect *bloom, i32 start_width, i32
     bloom->bloom_shader = LoadShader(0, "shaders/bloom.frag");
 #endif
 
-    i32 width  = start_width;
-    i32 height = start_height;
+    i32 width     = start_width;
+    i32 height    = start_height;
+    bloom->format = format;
     for (i32 i = 0; i < countof(bloom->ping_pong_buffers); ++i) {
         for (i32 b = 0; b < countof(bloom->ping_pong_buffers[i]); ++b) {
-            bloom->ping_pong_buffers[i][b] = LoadRenderTexture(width, height);
+            bloom->ping_pong_buffers[i][b] = LoadRenderTargetWithFormat(width, height, &bloom->format);
             SetTextureFilter(bloom->ping_pong_buffers[i][b].texture, TEXTURE_FILTER_BILINEAR);
             SetTextureWrap(bloom->ping_pong_buffers[i][b].texture, TEXTURE_WRAP_CLAMP);
         }
@@ -28,6 +33,20 @@ static void InitializeBloomEffect(BloomScreenEffect *bloom, i32 start_width, i32
         height /= 2;
     }
 
+    bloom->tile_columns  = (start_width + BLOOM_TILE_SIZE - 1) / BLOOM_TILE_SIZE;
+    bloom->tile_rows     = (start_height + BLOOM_TILE_SIZE - 1) / BLOOM_TILE_SIZE;
+    bloom->tiles         = calloc(bloom->tile_columns * bloom->tile_rows, 1);
+    bloom->dilated_tiles = calloc(bloom->tile_columns * bloom->tile_rows, 2);
+
+    // Every level is downsampled from the one above with the blur shader still bound (one more blur pass, in the
+    // texels of the level above) and then blurred BLOOM_BLUR_PASS_COUNT times, so its reach in screen pixels adds
+    // to that of the levels above it
+    i32 reach = 0;
+    for (i32 i = 0; i < countof(bloom->tile_dilation); ++i) {
+        reach += ((BLOOM_BLUR_PASS_COUNT + 1) * BLOOM_BLUR_RADIUS + 1) << i;
+        bloom->tile_dilation[i] = (reach + BLOOM_TILE_SIZE - 1) / BLOOM_TILE_SIZE;
+    }
+
     bloom->texture_locations[0] = GetShaderLocation(bloom->bloom_shader, "bloomTexture1");
     bloom->texture_locations[1] = GetShaderLocation(bloom->bloom_shader, "bloomTexture2");
     bloom->texture_locations[2] = GetShaderLocation(bloom->bloom_shader, "bloomTexture3");
@@ -47,6 +66,110 @@ static void UnloadBloomEffect(BloomScreenEffect *bloom)
         UnloadRenderTexture(bloom->ping_pong_buffers[i][0]);
         UnloadRenderTexture(bloom->ping_pong_buffers[i][1]);
     }
+    free(bloom->tiles);
+    free(bloom->dilated_tiles);
+}
+
+static void ResetBloomTiles(BloomScreenEffect *bloom)
+{
+    memset(bloom->tiles, 0, bloom->tile_columns * bloom->tile_rows);
+}
+
+// Marks the tiles under something bright drawn within bounds, in screen pixels
+static void MarkBloomTiles(BloomScreenEffect *bloom, Rectangle bounds)
+{
+    i32 column_begin = si_max(0, (i32)floorf(bounds.x / BLOOM_TILE_SIZE));
+    i32 row_begin    = si_max(0, (i32)floorf(bounds.y / BLOOM_TILE_SIZE));
+    i32 column_end   = si_min(bloom->tile_columns, (i32)floorf((bounds.x + bounds.width) / BLOOM_TILE_SIZE) + 1);
+    i32 row_end      = si_min(bloom->tile_rows, (i32)floorf((bounds.y + bounds.height) / BLOOM_TILE_SIZE) + 1);
+
+    for (i32 row = row_begin; row < row_end; ++row) {
+        for (i32 column = column_begin; column < column_end; ++column) {
+            bloom->tiles[row * bloom->tile_columns + column] = 1;
+        }
+    }
+}
+
+// Sets every tile within radius tiles of a marked one along the line of count tiles starting at from[0], stepping
+// by stride. The result goes to the same tiles of to.
+static void DilateBloomTiles(const u8 *from, u8 *to, i32 count, i32 stride, i32 radius)
+{
+    i32 last = -radius - 1;
+    for (i32 i = 0; i < count; ++i) {
+        if (from[i * stride]) last = i;
+        to[i * stride] = (i - last <= radius);
+    }
+
+    last = count + radius;
+    for (i32 i = count - 1; i >= 0; --i) {
+        if (from[i * stride]) last = i;
+        to[i * stride] |= (last - i <= radius);
+    }
+}
+
+// Covers the marked tiles, grown by how far the level spreads them, with rectangles in [0, 1] screen coordinates:
+// runs of tiles in a row, merged with the same run in the rows below. Returns the rectangle count.
+static i32 GetBloomLevelRects(BloomScreenEffect *bloom, i32 level, Rectangle *rects)
+{
+    i32 columns = bloom->tile_columns;
+    i32 rows    = bloom->tile_rows;
+    i32 radius  = bloom->tile_dilation[level];
+    u8 *grown   = bloom->dilated_tiles;
+    u8 *dilated = bloom->dilated_tiles + columns * rows;
+
+    for (i32 row = 0; row < rows; ++row) {
+        DilateBloomTiles(bloom->tiles + row * columns, grown + row * columns, columns, 1, radius);
+    }
+    for (i32 column = 0; column < columns; ++column) {
+        DilateBloomTiles(grown + column, dilated + column, rows, columns, radius);
+    }
+
+    struct {
+        i32 column_begin, column_end, row_begin, row_end;
+    } tile_rects[BLOOM_TILE_RECT_CAPACITY];
+    i32 count = 0;
+
+    for (i32 row = 0; row < rows; ++row) {
+        for (i32 column = 0; column < columns;) {
+            if (!dilated[row * columns + column]) {
+                column++;
+                continue;
+            }
+
+            i32 run_begin = column;
+            while (column < columns && dilated[row * columns + column]) column++;
+
+            b32 merged = false;
+            for (i32 i = 0; i < count && !merged; ++i) {
+                if (tile_rects[i].row_end == row && tile_rects[i].column_begin == run_begin && tile_rects[i].column_end == column) {
+                    tile_rects[i].row_end = row + 1;
+                    merged                = true;
+                }
+            }
+            if (merged) continue;
+
+            if (count == BLOOM_TILE_RECT_CAPACITY) {
+                rects[0] = (Rectangle){0.0f, 0.0f, 1.0f, 1.0f};
+                return 1;
+            }
+            tile_rects[count].column_begin = run_begin;
+            tile_rects[count].column_end   = column;
+            tile_rects[count].row_begin    = row;
+            tile_rects[count].row_end      = row + 1;
+            count++;
+        }
+    }
+
+    f32 width  = bloom->ping_pong_buffers[0][0].texture.width;
+    f32 height = bloom->ping_pong_buffers[0][0].texture.height;
+    for (i32 i = 0; i < count; ++i) {
+        f32 x0   = tile_rects[i].column_begin * BLOOM_TILE_SIZE / width;
+        f32 y0   = tile_rects[i].row_begin * BLOOM_TILE_SIZE / height;
+        f32 x1   = si_min(1.0f, tile_rects[i].column_end * BLOOM_TILE_SIZE / width);
+        f32 y1   = si_min(1.0f, tile_rects[i].row_end * BLOOM_TILE_SIZE / height);
+        rects[i] = (Rectangle){x0, y0, x1 - x0, y1 - y0};
+    }
+    return count;
 }
 
 void DrawFramebuffer(RenderTexture2D src, RenderTexture2D dst, b32 clear)
@@ -62,8 +185,43 @@ void DrawFramebuffer(RenderTexture2D src, RenderTexture2D dst, b32 clear)
     EndTextureMode();
 }
 
+// Like DrawFramebuffer, but only draws the parts of dst within rects, given in [0, 1] screen coordinates. All of them
+// go out in one batch.
+static void DrawFramebufferRects(RenderTexture2D src, RenderTexture2D dst, b32 clear, const Rectangle *rects, i32 count)
+{
+    f32 src_width  = src.texture.width;
+    f32 src_height = src.texture.height;
+    f32 dst_width  = dst.texture.width;
+    f32 dst_height = dst.texture.height;
+
+    BeginTextureMode(dst);
+    if (clear) ClearBackground(BLACK);
+    for (i32 i = 0; i < count; ++i) {
+        Rectangle r = rects[i];
+        // NOTE: Render textures are stored upside down, so the source rectangle is flipped to match
+        DrawTexturePro(src.texture,
+            (Rectangle){r.x * src_width, (1.0f - r.y - r.height) * src_height, r.width * src_width, -r.height * src_height},
+            (Rectangle){r.x * dst_width, r.y * dst_height, r.width * dst_width, r.height * dst_height},
+            (Vector2){0, 0},
+            0.0f,
+            WHITE);
+    }
+    EndTextureMode();
+}
+
+// Outside of the rectangles of a level both of its buffers stay cleared, which is what blurring the dark parts of the
+// screen would have left there too
+static const char *bloom_level_zone_names[BLOOM_PING_PONG_BUFFER_COUNT] = {
+    "bloom level 0",
+    "bloom level 1",
+    "bloom level 2",
+    "bloom level 3",
+};
+
 static void RenderBloomTextures(GameState *state)
 {
+    PROFILE_ZONE("RenderBloomTextures");
+
     BloomScreenEffect *bloom = &state->bloom;
 
     //======== Run Blur Passes =========
@@ -74,24 +232,93 @@ static void RenderBloomTextures(GameState *state)
     b32 horizontal = true;
     SetShaderValue(bloom->blur_shader, loc, &horizontal, SHADER_UNIFORM_INT);
 
+    f32 covered_texels = 0.0f;
+    f32 total_texels   = 0.0f;
     for (i32 set = 0; set < countof(bloom->ping_pong_buffers); ++set) {
+        PROFILE_ZONE(bloom_level_zone_names[set]);
+
         RenderTexture *buf0 = &bloom->ping_pong_buffers[set][0];
         RenderTexture *buf1 = &bloom->ping_pong_buffers[set][1];
 
+        Rectangle rects[BLOOM_TILE_RECT_CAPACITY];
+        i32       rect_count = GetBloomLevelRects(bloom, set, rects);
+
+        f32 texels = (f32)buf0->texture.width * buf0->texture.height;
+        for (i32 i = 0; i < rect_count; ++i) {
+            covered_texels += rects[i].width * rects[i].height * texels;
+        }
+        total_texels += texels;
+
+        BeginTextureMode(*buf1);
+        ClearBackground(BLACK);
+        EndTextureMode();
+
         if (set == 0) {
-            DrawFramebuffer(state->render_targets[1], *buf0, true);
+            DrawFramebufferRects(state->render_targets[1], *buf0, true, rects, rect_count);
         } else {
-            DrawFramebuffer(bloom->ping_pong_buffers[set - 1][0], *buf0, true);
+            DrawFramebufferRects(bloom->ping_pong_buffers[set - 1][0], *buf0, true, rects, rect_count);
         }
 
         for (i32 i = 0; i < BLOOM_BLUR_PASS_COUNT; ++i) {
             horizontal = true;
             SetShaderValue(bloom->blur_shader, loc, &horizontal, SHADER_UNIFORM_INT);
-            DrawFramebuffer(*buf0, *buf1, false);
+            DrawFramebufferRects(*buf0, *buf1, false, rects, rect_count);
 
             horizontal = false;
             SetShaderValue(bloom->blur_shader, loc, &horizontal, SHADER_UNIFORM_INT);
-            DrawFramebuffer(*buf1, *buf0, i == 0);
+            DrawFramebufferRects(*buf1, *buf0, false, rects, rect_count);
         }
     }
+
+    bloom->coverage = covered_texels / total_texels;
+}
+
+// Rough traffic of every pass per frame: each draw writes its whole target once and reads its source once,
+// ignoring overdraw and texture caches. Logged at startup to weigh HDR formats against bandwidth. Bloom is counted
+// for a screen full of bright tiles; it only processes bloom.coverage of that.
+static void ReportRenderTargets(GameState *state)
+{
+    BloomScreenEffect *bloom = &state->bloom;
+
+    i64 scene_size = GetRenderTargetSize(state->render_targets[0], state->target_formats[RENDER_PASS_SCENE]);
+    i64 fxaa_size  = GetRenderTargetSize(state->render_targets[1], state->target_formats[RENDER_PASS_FXAA]);
+
+    i64 memory[RENDER_PASS_COUNT]  = {scene_size, fxaa_size, 0};
+    i64 traffic[RENDER_PASS_COUNT] = {scene_size, scene_size + fxaa_size, 0};
+
+    // The composite reads the scene and the first buffer of every bloom level and writes the RGBA8 backbuffer
+    i64 composite   = fxaa_size + state->render_targets[1].texture.width * state->render_targets[1].texture.height * 4;
+    i64 source_size = fxaa_size;
+    for (i32 i = 0; i < countof(bloom->ping_pong_buffers); ++i) {
+        i64 size = GetRenderTargetSize(bloom->ping_pong_buffers[i][0], bloom->format);
+
+        memory[RENDER_PASS_BLOOM] += size * countof(bloom->ping_pong_buffers[i]);
+        traffic[RENDER_PASS_BLOOM] += source_size + size;                    // Downsample
+        traffic[RENDER_PASS_BLOOM] += BLOOM_BLUR_PASS_COUNT * 2 * (size * 2); // Horizontal and vertical blur
+        composite += size;
+        source_size = size;
+    }
+
+    i64 total_memory  = 0;
+    i64 total_traffic = composite;
+    for (i32 i = 0; i < RENDER_PASS_COUNT; ++i) {
+        RenderTargetFormat format = (i == RENDER_PASS_BLOOM) ? bloom->format : state->target_formats[i];
+        TraceLog(LOG_INFO,
+            "RENDER: %-9s %-10s %6.1f MB of targets, %6.1f MB/frame",
+            render_pass_names[i],
+            render_target_format_names[format],
+            memory[i] / 1.0e6,
+            traffic[i] / 1.0e6);
+
+        total_memory += memory[i];
+        total_traffic += traffic[i];
+    }
+
+    TraceLog(LOG_INFO, "RENDER: %-9s %-10s %6.1f MB of targets, %6.1f MB/frame", "composite", "rgba8", 0.0, composite / 1.0e6);
+    TraceLog(LOG_INFO,
+        "RENDER: %.1f MB of targets, %.1f MB/frame, %.2f GB/s at %d fps",
+        total_memory / 1.0e6,
+        total_traffic / 1.0e6,
+        total_traffic * state->target_fps / 1.0e9,
+        state->target_fps);
 }
@@ -3,6 +3,7 @@
 
 #include "../include/raylib.h"
 #include "asteroids.h"
+#include "render_target.h"
 
 #if defined(PLATFORM_WEB)
 #define BLOOM_BLUR_PASS_COUNT 2
@@ -12,11 +13,33 @@
 
 #define BLOOM_PING_PONG_BUFFER_COUNT 4
 
+// Bloom only runs on the screen tiles that have bright content, grown by how far each level spreads it. Tiles are
+// BLOOM_TILE_SIZE screen pixels, so BLOOM_TILE_SIZE >> level texels on each level.
+#define BLOOM_TILE_SIZE 64
+
+// Screen pixels added around marked shapes, for line caps and the FXAA pass
+#define BLOOM_TILE_MARGIN 4.0f
+
+// Texels the blur shader (gaussian_blur.frag) reaches to either side in one pass
+#define BLOOM_BLUR_RADIUS 4
+
+// Rectangles of tiles drawn per level; past this a level is drawn whole
+#define BLOOM_TILE_RECT_CAPACITY 256
+
 typedef struct BloomScreenEffect {
     Shader          bloom_shader;
     Shader          blur_shader;
-    RenderTexture2D ping_pong_buffers[BLOOM_PING_PONG_BUFFER_COUNT][2];
-    i32             texture_locations[BLOOM_PING_PONG_BUFFER_COUNT];
+    RenderTexture2D    ping_pong_buffers[BLOOM_PING_PONG_BUFFER_COUNT][2];
+    RenderTargetFormat format;
+    i32                texture_locations[BLOOM_PING_PONG_BUFFER_COUNT];
+
+    // Tiles with bright content this frame, marked while the scene is drawn
+    u8 *tiles;
+    u8 *dilated_tiles;
+    i32 tile_columns;
+    i32 tile_rows;
+    i32 tile_dilation[BLOOM_PING_PONG_BUFFER_COUNT]; // In tiles, how far content has spread by the end of a level
+    f32 coverage;                                    // Share of the bloom texels processed last frame
 } BloomScreenEffect;
 
 #endif // BLOOM_EFFECT_HEADER_GUARD
@@ -0,0 +1,326 @@
+#include "capture.h"
+#include "../include/raylib.h"
+#include "asteroids.h"
+#include "gl.h"
+#include "jobs.h"
+#include "profile.h"
+#include "types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// NOTE: WebGL caps client waits at 0; the buffer is a few frames old by the time it is read anyway
+#if defined(PLATFORM_WEB)
+#define CAPTURE_FENCE_TIMEOUT 0
+#else
+#define CAPTURE_FENCE_TIMEOUT 100000000 // ns
+#endif
+
+// Without a writer thread every frame is written as soon as it is read back, so one slot is enough
+#if defined(ASTEROIDS_THREADS)
+#define CAPTURE_WRITER_SLOTS CAPTURE_QUEUE_DEPTH
+#else
+#define CAPTURE_WRITER_SLOTS 1
+#endif
+
+// Rows come back bottom-up from GL. Y4M gets full range BT.601 (C420jpeg) with chroma averaged over 2x2 pixels.
+static void WriteCapturedFrame(FrameCapture *capture, const u8 *pixels, i64 frame)
+{
+    PROFILE_ZONE("WriteCapturedFrame");
+
+    i32 width  = capture->width;
+    i32 height = capture->height;
+    i32 stride = width * 4;
+
+    if (capture->format == CAPTURE_FORMAT_Y4M) {
+        u8 *y_plane = capture->scratch;
+        u8 *u_plane = y_plane + width * height;
+        u8 *v_plane = u_plane + (width / 2) * (height / 2);
+
+        for (i32 y = 0; y < height; y += 2) {
+            const u8 *row0 = pixels + (height - 1 - y) * stride;
+            const u8 *row1 = row0 - stride;
+
+            for (i32 x = 0; x < width; x += 2) {
+                const u8 *p[4] = {row0 + x * 4, row0 + x * 4 + 4, row1 + x * 4, row1 + x * 4 + 4};
+
+                i32 r = 0, g = 0, b = 0;
+                for (i32 i = 0; i < 4; ++i) {
+                    y_plane[(y + i / 2) * width + x + i % 2] = (77 * p[i][0] + 150 * p[i][1] + 29 * p[i][2] + 128) >> 8;
+
+                    r += p[i][0];
+                    g += p[i][1];
+                    b += p[i][2];
+                }
+
+                i32 u = (-43 * r - 85 * g + 128 * b + (128 << 10) + 512) >> 10;
+                i32 v = (128 * r - 107 * g - 21 * b + (128 << 10) + 512) >> 10;
+
+                u_plane[(y / 2) * (width / 2) + x / 2] = si_min(u, 255);
+                v_plane[(y / 2) * (width / 2) + x / 2] = si_min(v, 255);
+            }
+        }
+
+        fputs("FRAME\n", capture->file);
+        fwrite(capture->scratch, 1, width * height * 3 / 2, capture->file);
+    } else {
+        for (i32 y = 0; y < height; ++y) {
+            u8 *row = capture->scratch + y * stride;
+            memcpy(row, pixels + (height - 1 - y) * stride, stride);
+            for (i32 x = 0; x < width; ++x) row[x * 4 + 3] = 255;
+        }
+
+        // NOTE: Not TextFormat, its buffers are shared with the render thread
+        char file_name[sizeof(capture->path) + 16];
+        snprintf(file_name, sizeof(file_name), "%s_%06lld.png", capture->path, (long long)frame);
+
+        Image image = {capture->scratch, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+        ExportImage(image, file_name);
+    }
+}
+
+#if defined(ASTEROIDS_THREADS)
+static void *CaptureWriterMain(void *arg)
+{
+    FrameCapture *capture = (FrameCapture *)arg;
+    PROFILE_THREAD_NAME("capture writer", -1);
+
+    pthread_mutex_lock(&capture->mutex);
+    for (;;) {
+        while (!capture->quit && capture->queue_count == 0) {
+            pthread_cond_wait(&capture->frame_queued, &capture->mutex);
+        }
+        if (capture->queue_count == 0) break; // Quit, and everything queued is written
+
+        i32 slot = capture->queue_head;
+        pthread_mutex_unlock(&capture->mutex);
+
+        WriteCapturedFrame(capture, capture->queue_pixels[slot], capture->queue_frames[slot]);
+
+        pthread_mutex_lock(&capture->mutex);
+        capture->queue_head = (slot + 1) % CAPTURE_WRITER_SLOTS;
+        capture->queue_count--;
+        capture->frames_written++;
+        pthread_cond_signal(&capture->frame_written);
+    }
+    pthread_mutex_unlock(&capture->mutex);
+
+    PROFILE_THREAD_END();
+    return NULL;
+}
+#endif
+
+// Slot for the next frame, or -1 when the writer is behind and the frame has to be dropped
+static i32 ReserveCaptureSlot(FrameCapture *capture)
+{
+#if defined(ASTEROIDS_THREADS)
+    pthread_mutex_lock(&capture->mutex);
+    while (capture->lossless && capture->queue_count == CAPTURE_WRITER_SLOTS) {
+        pthread_cond_wait(&capture->frame_written, &capture->mutex);
+    }
+
+    i32 slot = -1;
+    if (capture->queue_count < CAPTURE_WRITER_SLOTS) {
+        slot = (capture->queue_head + capture->queue_count) % CAPTURE_WRITER_SLOTS;
+    }
+    pthread_mutex_unlock(&capture->mutex);
+    return slot;
+#else
+    return 0;
+#endif
+}
+
+static void SubmitCaptureSlot(FrameCapture *capture, i32 slot, i64 frame)
+{
+    capture->queue_frames[slot] = frame;
+
+#if defined(ASTEROIDS_THREADS)
+    pthread_mutex_lock(&capture->mutex);
+    capture->queue_count++;
+    pthread_cond_signal(&capture->frame_queued);
+    pthread_mutex_unlock(&capture->mutex);
+#else
+    WriteCapturedFrame(capture, capture->queue_pixels[slot], frame);
+    capture->frames_written++;
+#endif
+}
+
+// Copies a finished readback out of its pixel buffer and hands it to the writer
+static void CollectPixelBuffer(FrameCapture *capture, i32 index)
+{
+    i64 frame = capture->pending_frames[index];
+    if (frame < 0) return;
+
+    capture->pending_frames[index] = -1;
+
+    // Signaled long ago unless the GPU is several frames behind
+    glClientWaitSync(capture->fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, CAPTURE_FENCE_TIMEOUT);
+    glDeleteSync(capture->fences[index]);
+    capture->fences[index] = NULL;
+
+    i32 slot = ReserveCaptureSlot(capture);
+    if (slot < 0) {
+        capture->frames_dropped++;
+        return;
+    }
+
+    i32 size   = capture->width * capture->height * 4;
+    b32 copied = true;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->pixel_buffers[index]);
+#if defined(PLATFORM_WEB)
+    glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, size, capture->queue_pixels[slot]);
+#else
+    void *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (pixels) {
+        memcpy(capture->queue_pixels[slot], pixels, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    copied = pixels != NULL;
+#endif
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (copied) {
+        SubmitCaptureSlot(capture, slot, frame);
+    } else {
+        capture->frames_dropped++;
+    }
+}
+
+static void UnloadCaptureResources(FrameCapture *capture)
+{
+    glDeleteBuffers(CAPTURE_PIXEL_BUFFER_COUNT, capture->pixel_buffers);
+    UnloadRenderTexture(capture->target);
+
+    for (i32 i = 0; i < CAPTURE_WRITER_SLOTS; ++i) {
+        free(capture->queue_pixels[i]);
+    }
+    free(capture->scratch);
+
+    if (capture->file) fclose(capture->file);
+    capture->file = NULL;
+}
+
+// Frames are composed into a screen sized target and read back width x height rounded down to even sizes.
+// path is the Y4M file, or the prefix of the PNG files.
+static b32 StartCapture(
+    FrameCapture *capture, i32 screen_width, i32 screen_height, i32 fps, CaptureFormat format, const char *path, b32 lossless)
+{
+    if (!LoadGLFunctions()) {
+        TraceLog(LOG_WARNING, "CAPTURE: Pixel buffer objects are not available");
+        return false;
+    }
+
+    *capture = (FrameCapture){
+        .lossless          = lossless,
+        .format            = format,
+        .width             = screen_width & ~1,
+        .height            = screen_height & ~1,
+        .fps               = fps,
+        .next_pixel_buffer = 0,
+    };
+    snprintf(capture->path, sizeof(capture->path), "%s", path);
+
+    if (format == CAPTURE_FORMAT_Y4M) {
+        capture->file = fopen(path, "wb");
+        if (!capture->file) {
+            TraceLog(LOG_WARNING, "CAPTURE: Could not open %s", path);
+            return false;
+        }
+        fprintf(capture->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", capture->width, capture->height, fps);
+    }
+
+    i32 size        = capture->width * capture->height * 4;
+    capture->target = LoadRenderTexture(screen_width, screen_height);
+
+    glGenBuffers(CAPTURE_PIXEL_BUFFER_COUNT, capture->pixel_buffers);
+    for (i32 i = 0; i < CAPTURE_PIXEL_BUFFER_COUNT; ++i) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->pixel_buffers[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+        capture->pending_frames[i] = -1;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    for (i32 i = 0; i < CAPTURE_WRITER_SLOTS; ++i) {
+        capture->queue_pixels[i] = malloc(size);
+    }
+    capture->scratch = malloc(size);
+
+#if defined(ASTEROIDS_THREADS)
+    pthread_mutex_init(&capture->mutex, NULL);
+    pthread_cond_init(&capture->frame_queued, NULL);
+    pthread_cond_init(&capture->frame_written, NULL);
+    if (pthread_create(&capture->writer, NULL, CaptureWriterMain, capture) != 0) {
+        pthread_cond_destroy(&capture->frame_written);
+        pthread_cond_destroy(&capture->frame_queued);
+        pthread_mutex_destroy(&capture->mutex);
+        UnloadCaptureResources(capture);
+        return false;
+    }
+#endif
+
+    capture->start_time = GetTime();
+    capture->active     = true;
+    TraceLog(LOG_INFO, "CAPTURE: Recording %dx%d to %s", capture->width, capture->height, path);
+    return true;
+}
+
+// Issues the readback of the frame just drawn into capture->target and collects the one issued
+// CAPTURE_PIXEL_BUFFER_COUNT frames ago. Call outside of texture mode.
+static void CaptureFrame(FrameCapture *capture)
+{
+    if (!capture->active) return;
+
+    f64 start = GetTime();
+    i32 index = capture->next_pixel_buffer;
+    CollectPixelBuffer(capture, index);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, capture->target.id);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->pixel_buffers[index]);
+    glReadPixels(0, 0, capture->width, capture->height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    capture->fences[index]         = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    capture->pending_frames[index] = capture->frames_issued++;
+    capture->next_pixel_buffer     = (index + 1) % CAPTURE_PIXEL_BUFFER_COUNT;
+
+    f64 elapsed               = GetTime() - start;
+    capture->capture_time += elapsed;
+    capture->capture_time_max = si_max(capture->capture_time_max, elapsed);
+}
+
+static void StopCapture(FrameCapture *capture)
+{
+    if (!capture->active) return;
+
+    // Collect the readbacks still in flight, oldest first
+    for (i32 i = 0; i < CAPTURE_PIXEL_BUFFER_COUNT; ++i) {
+        CollectPixelBuffer(capture, (capture->next_pixel_buffer + i) % CAPTURE_PIXEL_BUFFER_COUNT);
+    }
+
+#if defined(ASTEROIDS_THREADS)
+    pthread_mutex_lock(&capture->mutex);
+    capture->quit = true;
+    pthread_cond_signal(&capture->frame_queued);
+    pthread_mutex_unlock(&capture->mutex);
+
+    pthread_join(capture->writer, NULL);
+    pthread_cond_destroy(&capture->frame_written);
+    pthread_cond_destroy(&capture->frame_queued);
+    pthread_mutex_destroy(&capture->mutex);
+#endif
+
+    UnloadCaptureResources(capture);
+    capture->active = false;
+
+    f64 elapsed = GetTime() - capture->start_time;
+    TraceLog(LOG_INFO,
+        "CAPTURE: %s: %lld frames written, %lld dropped, %.1f fps, %.3f ms/frame on the render thread (max %.3f ms)",
+        capture->path,
+        (long long)capture->frames_written,
+        (long long)capture->frames_dropped,
+        capture->frames_written / (si_max(elapsed, 1.0e-6)),
+        capture->capture_time * 1000.0 / (si_max(capture->frames_issued, 1)),
+        capture->capture_time_max * 1000.0);
+}
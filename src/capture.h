@@ -0,0 +1,65 @@
+#ifndef CAPTURE_HEADER_GUARD
+#define CAPTURE_HEADER_GUARD
+
+#include "../include/raylib.h"
+#include "jobs.h"
+#include "types.h"
+
+#include <stdio.h>
+
+// Frames between issuing a readback and copying it out. By then the GPU has long finished it, so the copy never
+// waits on the GPU the way a plain glReadPixels does.
+#define CAPTURE_PIXEL_BUFFER_COUNT 3
+
+// Frames waiting for the writer. Bounds the memory use to this many frames; when the writer falls behind live
+// captures drop frames and offline captures wait.
+#define CAPTURE_QUEUE_DEPTH 4
+
+typedef enum CaptureFormat {
+    CAPTURE_FORMAT_Y4M, // One raw YUV 4:2:0 stream, e.g. for `ffmpeg -i capture.y4m capture.mp4`
+    CAPTURE_FORMAT_PNG, // Numbered images
+} CaptureFormat;
+
+typedef struct FrameCapture {
+    b32           active;
+    b32           lossless; // Wait for the writer instead of dropping frames
+    CaptureFormat format;
+    i32           width;
+    i32           height;
+    i32           fps;
+    char          path[256]; // Y4M file, or PNG prefix
+
+    // The frame is composed here and read back from it, then drawn to the screen
+    RenderTexture2D target;
+
+    u32   pixel_buffers[CAPTURE_PIXEL_BUFFER_COUNT];
+    void *fences[CAPTURE_PIXEL_BUFFER_COUNT];
+    i64   pending_frames[CAPTURE_PIXEL_BUFFER_COUNT]; // Frame number in each pixel buffer, -1 when empty
+    i32   next_pixel_buffer;
+
+    // FIFO of frames for the writer
+    u8 *queue_pixels[CAPTURE_QUEUE_DEPTH];
+    i64 queue_frames[CAPTURE_QUEUE_DEPTH];
+    i32 queue_head;
+    i32 queue_count;
+
+    FILE *file;
+    u8   *scratch; // Writer's conversion buffer
+
+    i64 frames_issued;
+    i64 frames_written;
+    i64 frames_dropped;
+    f64 capture_time; // Time CaptureFrame spent on the calling thread
+    f64 capture_time_max;
+    f64 start_time;
+
+#if defined(ASTEROIDS_THREADS)
+    pthread_t       writer;
+    pthread_mutex_t mutex;
+    pthread_cond_t  frame_queued;
+    pthread_cond_t  frame_written;
+    b32             quit;
+#endif
+} FrameCapture;
+
+#endif // CAPTURE_HEADER_GUARD
@@ -0,0 +1,20 @@
+#include "types.h"
+
+#include <time.h>
+
+#if defined(__EMSCRIPTEN__)
+#include <emscripten/emscripten.h>
+#endif
+
+// Seconds on a monotonic clock. raylib's GetTime reads the GLFW timer, which only starts with the window, so the
+// tools that never open one time themselves with this.
+static f64 GetMonotonicTime()
+{
+#if defined(__EMSCRIPTEN__)
+    return emscripten_get_now() / 1000.0;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (f64)now.tv_sec + now.tv_nsec / 1.0e9;
+#endif
+}
@@ -0,0 +1,75 @@
+/**************************************************************************
+    Sound asset conversion. Encodes every WAV in the sound directory as QOA
+    next to it with raylib's own encoder; the game only loads the QOA files
+    and the web build leaves the WAVs out of its data bundle. Prints the
+    size and decode time of each sound in both formats.
+
+    usage: convert_sounds [directory]
+***************************************************************************/
+
+#include <stdio.h>
+
+#include "../include/raylib.h"
+#include "audio.h"
+#include "types.h"
+
+#include "clock.c"
+
+int main(int argc, char **argv)
+{
+    const char *directory = (argc > 1) ? argv[1] : SOUND_DIRECTORY;
+    SetTraceLogLevel(LOG_WARNING);
+
+    FilePathList files = LoadDirectoryFilesEx(directory, ".wav", false);
+
+    i64 wav_bytes = 0;
+    i64 qoa_bytes = 0;
+    f64 wav_time  = 0.0;
+    f64 qoa_time  = 0.0;
+
+    printf("%-24s %10s %10s %10s %10s\n", "sound", "wav KB", "qoa KB", "wav ms", "qoa ms");
+    for (u32 i = 0; i < files.count; ++i) {
+        const char *wav_path = files.paths[i];
+
+        char qoa_path[512];
+        snprintf(qoa_path, sizeof(qoa_path), "%s/%s%s", directory, GetFileNameWithoutExt(wav_path), SOUND_FILE_EXTENSION);
+
+        f64  start      = GetMonotonicTime();
+        Wave wave       = LoadWave(wav_path);
+        f64  wav_decode = GetMonotonicTime() - start;
+
+        // NOTE: QOA only holds 16-bit samples
+        if (wave.sampleSize != 16) WaveFormat(&wave, wave.sampleRate, 16, wave.channels);
+        b32 exported = ExportWave(wave, qoa_path);
+        UnloadWave(wave);
+
+        if (!exported) {
+            fprintf(stderr, "could not write %s\n", qoa_path);
+            continue;
+        }
+
+        start          = GetMonotonicTime();
+        wave           = LoadWave(qoa_path);
+        f64 qoa_decode = GetMonotonicTime() - start;
+        UnloadWave(wave);
+
+        i32 wav_size = GetFileLength(wav_path);
+        i32 qoa_size = GetFileLength(qoa_path);
+        printf("%-24s %10.1f %10.1f %10.3f %10.3f\n",
+            GetFileName(qoa_path),
+            wav_size / 1024.0,
+            qoa_size / 1024.0,
+            wav_decode * 1000.0,
+            qoa_decode * 1000.0);
+
+        wav_bytes += wav_size;
+        qoa_bytes += qoa_size;
+        wav_time  += wav_decode;
+        qoa_time  += qoa_decode;
+    }
+
+    printf("%-24s %10.1f %10.1f %10.3f %10.3f\n", "total", wav_bytes / 1024.0, qoa_bytes / 1024.0, wav_time * 1000.0, qoa_time * 1000.0);
+
+    UnloadDirectoryFiles(files);
+    return 0;
+}
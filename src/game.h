@@ -2,13 +2,45 @@
 #define GAME_HEADER_GUARD
 
 #include "asteroids.h"
+#include "audio.h"
 #include "bloom.h"
+#include "capture.h"
+#include "hud.h"
+#include "jobs.h"
+#include "latency.h"
+#include "render_target.h"
+#include "replay.h"
+#include "rng.h"
 
 #define STARTING_WINDOW_WIDTH 1920
 #define STARTING_WINDOW_HEIGHT 1080
 
-#define WORLD_WIDTH 2560
-#define WORLD_HEIGHT 1440
+// Area of the world the camera shows at once
+#define VIEW_WIDTH 2560
+#define VIEW_HEIGHT 1440
+
+// The world is WORLD_SCALE views wide and tall; the camera follows the player when it is larger than one view.
+// Large worlds need a bigger asteroid buffer too, e.g. -DWORLD_SCALE=10 -DASTEROID_BUFFER_CAPACITY=16384
+#ifndef WORLD_SCALE
+#define WORLD_SCALE 1
+#endif
+
+#define WORLD_WIDTH (VIEW_WIDTH * WORLD_SCALE)
+#define WORLD_HEIGHT (VIEW_HEIGHT * WORLD_SCALE)
+
+#define ASTEROIDS_PER_VIEW 24
+
+// Asteroids further than this outside the view are only integrated every ASTEROID_LOD_STEP seconds and don't rotate
+#define ASTEROID_LOD_MARGIN 512.0f
+#define ASTEROID_LOD_STEP 0.25f
+
+// Asteroid outlines are drawn with fewer of their vertices as they get smaller on screen, down to a single quad.
+// A level changes once the size is this far past its threshold, so asteroids near one don't flicker between two.
+#define ASTEROID_OUTLINE_LOD_COUNT 4
+#define ASTEROID_OUTLINE_LOD_HYSTERESIS 0.15f
+
+// Frame rate of screens where nothing moves (game over, won, paused)
+#define STATIC_SCREEN_FPS 15
 
 typedef enum SoundNames {
     SOUND_SHOOT,
@@ -20,30 +52,69 @@ typedef enum SoundNames {
     SOUND_COUNT,
 } SoundNames;
 
+// Every system draws from its own stream so e.g. sound pitch never shifts the asteroid shapes of a seed
+typedef enum RandomStreamNames {
+    RANDOM_STREAM_ASTEROIDS,
+    RANDOM_STREAM_POWER_UPS,
+    RANDOM_STREAM_SOUND,
+    RANDOM_STREAM_COUNT,
+} RandomStreamNames;
+
 typedef struct GameState {
     b32 resources_loaded;
     b32 game_over;
     b32 game_won;
+    b32 paused;
     i32 screen_width;
     i32 screen_height;
 
+    // Game clock, advanced by the frame times Update is given so that replays reproduce it
+    f64 time;
+
     Vector2 world_min;
     Vector2 world_max;
 
-    Player   player;
-    Camera2D camera;
+    Player    player;
+    Camera2D  camera;
+    Rectangle view; // World space rectangle the camera shows
 
     BulletBuffer   bullet_buffer;
     AsteroidBuffer asteroid_buffer;
     PowerUpBuffer  power_up_buffer;
 
-    RenderTexture2D   render_targets[2];
-    BloomScreenEffect bloom;
-    Shader            fxaa_shader;
+    JobPool      job_pool;
+    RandomStream random_streams[RANDOM_STREAM_COUNT];
+
+    RenderTexture2D    render_targets[2];
+    RenderTargetFormat target_formats[RENDER_PASS_COUNT];
+    BloomScreenEffect  bloom;
+    Shader             fxaa_shader;
+    HudLayer           hud;
+
+    // Last composed frame, reused while on a static screen so only the overlay is redrawn
+    RenderTexture2D frame_cache;
+    b32             frame_cache_valid;
+    b32             static_screen;
+    i32             target_fps;
+
+    FrameCapture capture;
+    Replay       replay;
+    b32          recording;
+
+    // Draw the ship towards the mouse as read right before the geometry pass instead of at the frame's poll
+    b32            late_latch;
+    LatencyMonitor latency;
+
+    // Ship outline as DrawScene last drew it, which replay renders check against the one Update produced
+    Vector2 drawn_player_vertices[4];
+#if defined(ASTEROIDS_CUSTOM_FRAME_CONTROL)
+    FrameScheduler frame_scheduler;
+#endif
 
-    Sound sounds[SOUND_COUNT];
+    GameSound sounds[SOUND_COUNT];
 
     b32 show_fps;
+    i32 outline_lod_counts[ASTEROID_OUTLINE_LOD_COUNT]; // Asteroids drawn at each outline level last frame
 } GameState;
 
 #endif // GAME_HEADER_GUARD
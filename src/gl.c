@@ -0,0 +1,53 @@
+#include "gl.h"
+#include "types.h"
+
+#include <string.h>
+
+#if !defined(PLATFORM_WEB)
+typedef void (*GLProc)(void);
+GLProc glfwGetProcAddress(const char *procname);
+
+static GLFunctions gl_functions;
+#endif
+
+// Needs the window (and so the GL context) to exist. Always succeeds on the web.
+static b32 LoadGLFunctions()
+{
+#if defined(PLATFORM_WEB)
+    return true;
+#else
+    if (gl_functions.loaded) return true;
+
+#define LOAD_GL_FUNCTION(name)                                                                                                             \
+    do {                                                                                                                                   \
+        GLProc proc = glfwGetProcAddress("gl" #name);                                                                                      \
+        memcpy(&gl_functions.name, &proc, sizeof(proc));                                                                                   \
+        loaded = loaded && proc;                                                                                                           \
+    } while (0)
+
+    b32 loaded = true;
+    LOAD_GL_FUNCTION(GenTextures);
+    LOAD_GL_FUNCTION(BindTexture);
+    LOAD_GL_FUNCTION(TexImage2D);
+    LOAD_GL_FUNCTION(TexParameteri);
+    LOAD_GL_FUNCTION(GenFramebuffers);
+    LOAD_GL_FUNCTION(BindFramebuffer);
+    LOAD_GL_FUNCTION(FramebufferTexture2D);
+    LOAD_GL_FUNCTION(CheckFramebufferStatus);
+    LOAD_GL_FUNCTION(GenBuffers);
+    LOAD_GL_FUNCTION(DeleteBuffers);
+    LOAD_GL_FUNCTION(BindBuffer);
+    LOAD_GL_FUNCTION(BufferData);
+    LOAD_GL_FUNCTION(MapBufferRange);
+    LOAD_GL_FUNCTION(UnmapBuffer);
+    LOAD_GL_FUNCTION(ReadPixels);
+    LOAD_GL_FUNCTION(FenceSync);
+    LOAD_GL_FUNCTION(ClientWaitSync);
+    LOAD_GL_FUNCTION(DeleteSync);
+    LOAD_GL_FUNCTION(Finish);
+#undef LOAD_GL_FUNCTION
+
+    gl_functions.loaded = loaded;
+    return loaded;
+#endif
+}
@@ -0,0 +1,96 @@
+#ifndef GL_HEADER_GUARD
+#define GL_HEADER_GUARD
+
+#include "types.h"
+
+#include <stdint.h>
+
+// The few GL entry points raylib doesn't wrap: pixel buffer objects and fences for frame capture, float render
+// targets and glFinish for latency measurements. The web build gets them from the GLES 3 headers.
+#if defined(PLATFORM_WEB)
+#include <GLES3/gl3.h>
+
+// NOTE: Not in the GLES 3 headers; emscripten implements it on top of WebGL 2's getBufferSubData, which is the
+// only way to read a buffer back there (no glMapBufferRange for reading).
+void glGetBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, void *data);
+#else
+// NOTE: Desktop builds fetch them through the GLFW that raylib links in. The enums are spelled out to not depend
+// on a GL header.
+#if defined(_WIN32) && !defined(_WIN64)
+#define GL_API __stdcall
+#else
+#define GL_API
+#endif
+
+#define GL_TEXTURE_2D 0x0DE1
+#define GL_TEXTURE_MAG_FILTER 0x2800
+#define GL_TEXTURE_MIN_FILTER 0x2801
+#define GL_TEXTURE_WRAP_S 0x2802
+#define GL_TEXTURE_WRAP_T 0x2803
+#define GL_LINEAR 0x2601
+#define GL_CLAMP_TO_EDGE 0x812F
+
+#define GL_RGB 0x1907
+#define GL_RGBA 0x1908
+#define GL_RGBA16F 0x881A
+#define GL_R11F_G11F_B10F 0x8C3A
+#define GL_UNSIGNED_BYTE 0x1401
+#define GL_HALF_FLOAT 0x140B
+
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_READ_FRAMEBUFFER 0x8CA8
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#define GL_STREAM_READ 0x88E1
+#define GL_MAP_READ_BIT 0x0001
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+
+typedef struct GLFunctions {
+    b32 loaded;
+    void(GL_API *GenTextures)(i32 count, u32 *textures);
+    void(GL_API *BindTexture)(u32 target, u32 texture);
+    void(GL_API *TexImage2D)(u32 target, i32 level, i32 internal_format, i32 width, i32 height, i32 border, u32 format, u32 type,
+        const void *pixels);
+    void(GL_API *TexParameteri)(u32 target, u32 name, i32 param);
+    void(GL_API *GenFramebuffers)(i32 count, u32 *framebuffers);
+    void(GL_API *BindFramebuffer)(u32 target, u32 framebuffer);
+    void(GL_API *FramebufferTexture2D)(u32 target, u32 attachment, u32 texture_target, u32 texture, i32 level);
+    u32(GL_API *CheckFramebufferStatus)(u32 target);
+    void(GL_API *GenBuffers)(i32 count, u32 *buffers);
+    void(GL_API *DeleteBuffers)(i32 count, const u32 *buffers);
+    void(GL_API *BindBuffer)(u32 target, u32 buffer);
+    void(GL_API *BufferData)(u32 target, intptr_t size, const void *data, u32 usage);
+    void *(GL_API *MapBufferRange)(u32 target, intptr_t offset, intptr_t length, u32 access);
+    u8(GL_API *UnmapBuffer)(u32 target);
+    void(GL_API *ReadPixels)(i32 x, i32 y, i32 width, i32 height, u32 format, u32 type, void *pixels);
+    void *(GL_API *FenceSync)(u32 condition, u32 flags);
+    u32(GL_API *ClientWaitSync)(void *sync, u32 flags, u64 timeout);
+    void(GL_API *DeleteSync)(void *sync);
+    void(GL_API *Finish)(void);
+} GLFunctions;
+
+#define glGenTextures gl_functions.GenTextures
+#define glBindTexture gl_functions.BindTexture
+#define glTexImage2D gl_functions.TexImage2D
+#define glTexParameteri gl_functions.TexParameteri
+#define glGenFramebuffers gl_functions.GenFramebuffers
+#define glBindFramebuffer gl_functions.BindFramebuffer
+#define glFramebufferTexture2D gl_functions.FramebufferTexture2D
+#define glCheckFramebufferStatus gl_functions.CheckFramebufferStatus
+#define glGenBuffers gl_functions.GenBuffers
+#define glDeleteBuffers gl_functions.DeleteBuffers
+#define glBindBuffer gl_functions.BindBuffer
+#define glBufferData gl_functions.BufferData
+#define glMapBufferRange gl_functions.MapBufferRange
+#define glUnmapBuffer gl_functions.UnmapBuffer
+#define glReadPixels gl_functions.ReadPixels
+#define glFenceSync gl_functions.FenceSync
+#define glClientWaitSync gl_functions.ClientWaitSync
+#define glDeleteSync gl_functions.DeleteSync
+#define glFinish gl_functions.Finish
+#endif
+
+#endif // GL_HEADER_GUARD
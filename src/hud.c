@@ -0,0 +1,60 @@
+#include "hud.h"
+#include "../include/raylib.h"
+#include "asteroids.h"
+#include "types.h"
+
+static const char power_up_letters[POWER_UP_TYPE_COUNT] = {'B', 'I', 'S', 'M'};
+
+static void InitializeHud(HudLayer *hud)
+{
+    hud->score_target   = LoadRenderTexture(HUD_SCORE_TARGET_WIDTH, HUD_SCORE_TARGET_HEIGHT);
+    hud->letters_target = LoadRenderTexture(HUD_LETTER_CELL_SIZE * POWER_UP_TYPE_COUNT, HUD_LETTER_CELL_SIZE);
+    hud->score_valid    = false;
+
+    SetTextureFilter(hud->letters_target.texture, TEXTURE_FILTER_BILINEAR);
+
+    BeginTextureMode(hud->letters_target);
+    ClearBackground(BLANK);
+    for (i32 i = 0; i < POWER_UP_TYPE_COUNT; ++i) {
+        DrawText(TextFormat("%c", power_up_letters[i]), i * HUD_LETTER_CELL_SIZE, 0, HUD_LETTER_FONT_SIZE, WHITE);
+    }
+    EndTextureMode();
+}
+
+static void UnloadHud(HudLayer *hud)
+{
+    UnloadRenderTexture(hud->score_target);
+    UnloadRenderTexture(hud->letters_target);
+}
+
+// NOTE: Must be called outside of any BeginTextureMode/EndTextureMode pair
+static void UpdateHud(HudLayer *hud, i32 score)
+{
+    if (hud->score_valid && hud->drawn_score == score) return;
+
+    BeginTextureMode(hud->score_target);
+    ClearBackground(BLANK);
+    DrawText(TextFormat("SCORE: %d", score), 0, HUD_SCORE_TARGET_HEIGHT - HUD_SCORE_FONT_SIZE, HUD_SCORE_FONT_SIZE, GRAY);
+    EndTextureMode();
+
+    hud->drawn_score = score;
+    hud->score_valid = true;
+}
+
+static void DrawHudScore(HudLayer *hud, f32 x, f32 bottom)
+{
+    Texture2D texture = hud->score_target.texture;
+    DrawTextureRec(texture, (Rectangle){0, 0, (f32)texture.width, (f32)-texture.height}, (Vector2){x, bottom - texture.height}, WHITE);
+}
+
+// Same placement as DrawText(letter, x, y, font_size) would give
+static void DrawPowerUpLetter(HudLayer *hud, enum PowerUpType type, f32 x, f32 y, i32 font_size)
+{
+    // NOTE: DrawText never goes below the default font size of 10
+    font_size = si_max(font_size, 10);
+    f32 scale = (f32)font_size / HUD_LETTER_FONT_SIZE;
+    f32 size  = HUD_LETTER_CELL_SIZE * scale;
+
+    Rectangle source = {type * HUD_LETTER_CELL_SIZE, 0, HUD_LETTER_CELL_SIZE, -HUD_LETTER_CELL_SIZE};
+    DrawTexturePro(hud->letters_target.texture, source, (Rectangle){x, y, size, size}, (Vector2){0, 0}, 0.0f, WHITE);
+}
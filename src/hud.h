@@ -0,0 +1,23 @@
+#ifndef HUD_HEADER_GUARD
+#define HUD_HEADER_GUARD
+
+#include "../include/raylib.h"
+#include "asteroids.h"
+
+#define HUD_SCORE_FONT_SIZE 36
+#define HUD_SCORE_TARGET_WIDTH 512
+#define HUD_SCORE_TARGET_HEIGHT 48
+
+// Power-up letters are rasterized once at their largest size and scaled down while power-ups grow in
+#define HUD_LETTER_FONT_SIZE 60
+#define HUD_LETTER_CELL_SIZE 64
+
+// Retained text: only re-rasterized when its content changes instead of DrawText'ing every frame
+typedef struct HudLayer {
+    RenderTexture2D score_target;
+    RenderTexture2D letters_target;
+    i32             drawn_score;
+    b32             score_valid;
+} HudLayer;
+
+#endif // HUD_HEADER_GUARD
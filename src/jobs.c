@@ -0,0 +1,169 @@
+#include "jobs.h"
+#include "profile.h"
+#include "types.h"
+
+#if defined(ASTEROIDS_THREADS)
+#include <sched.h>
+#include <unistd.h>
+#if defined(__EMSCRIPTEN__)
+#include <emscripten/threading.h>
+#endif
+
+typedef struct JobWorkerArgs {
+    JobPool *pool;
+    i32      worker_index;
+} JobWorkerArgs;
+
+static JobWorkerArgs job_worker_args[JOB_POOL_MAX_WORKERS];
+
+static void RunJobBatches(JobPool *pool, JobFunction function, void *user_data, i32 count, i32 batch_size, i32 batch_count, i32 worker)
+{
+    for (;;) {
+        i32 batch = atomic_fetch_add(&pool->next_batch, 1);
+        if (batch >= batch_count) break;
+
+        i32 begin = batch * batch_size;
+        i32 end   = begin + batch_size < count ? begin + batch_size : count;
+
+        PROFILE_ZONE("job batch");
+        function(user_data, begin, end, worker);
+
+        atomic_fetch_add(&pool->finished_batches, 1);
+    }
+}
+
+static void *JobWorkerMain(void *arg)
+{
+    JobWorkerArgs *args = (JobWorkerArgs *)arg;
+    JobPool       *pool = args->pool;
+    u32            seen = 0;
+    PROFILE_THREAD_NAME("worker", args->worker_index);
+
+    for (;;) {
+        pthread_mutex_lock(&pool->mutex);
+        while (!pool->quit && pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->mutex);
+        }
+
+        if (pool->quit) {
+            pthread_mutex_unlock(&pool->mutex);
+            break;
+        }
+
+        // NOTE: Snapshot the job while holding the lock. The dispatcher waits for active_workers to drop
+        // back to zero before resetting the batch counter, so a stale snapshot can never claim new batches.
+        seen                  = pool->generation;
+        JobFunction function  = pool->function;
+        void       *user_data = pool->user_data;
+        i32         count     = pool->count;
+        i32         size      = pool->batch_size;
+        i32         batches   = pool->batch_count;
+        atomic_fetch_add(&pool->active_workers, 1);
+        pthread_mutex_unlock(&pool->mutex);
+
+        RunJobBatches(pool, function, user_data, count, size, batches, args->worker_index);
+        atomic_fetch_sub(&pool->active_workers, 1);
+    }
+
+    PROFILE_THREAD_END();
+    return NULL;
+}
+
+static i32 GetLogicalCoreCount()
+{
+#if defined(__EMSCRIPTEN__)
+    return emscripten_num_logical_cores();
+#else
+    return (i32)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+}
+#endif
+
+// worker_count < 0 picks one worker per logical core, minus the calling thread.
+static void InitializeJobPool(JobPool *pool, i32 worker_count)
+{
+    pool->worker_count = 0;
+
+#if defined(ASTEROIDS_THREADS)
+    if (worker_count < 0) worker_count = GetLogicalCoreCount() - 1;
+    if (worker_count > JOB_POOL_MAX_WORKERS) worker_count = JOB_POOL_MAX_WORKERS;
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pool->generation = 0;
+    pool->quit       = false;
+    atomic_store(&pool->next_batch, 0);
+    atomic_store(&pool->finished_batches, 0);
+    atomic_store(&pool->active_workers, 0);
+
+    for (i32 i = 0; i < worker_count; ++i) {
+        job_worker_args[i] = (JobWorkerArgs){pool, i + 1};
+        if (pthread_create(&pool->threads[i], NULL, JobWorkerMain, &job_worker_args[i]) != 0) {
+            // NOTE: Happens on the web when SharedArrayBuffer is unavailable; just run with fewer workers.
+            break;
+        }
+        pool->worker_count++;
+    }
+#else
+    (void)worker_count;
+#endif
+}
+
+static void UnloadJobPool(JobPool *pool)
+{
+#if defined(ASTEROIDS_THREADS)
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (i32 i = 0; i < pool->worker_count; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->mutex);
+#endif
+    pool->worker_count = 0;
+}
+
+// Splits [0, count) into batches of batch_size and runs them on the pool. The calling thread always takes
+// batches too, so this never blocks on a worker that has not started yet (e.g. a browser worker that is
+// still spinning up); it only waits for batches another thread has already claimed.
+static void RunParallelFor(JobPool *pool, i32 count, i32 batch_size, JobFunction function, void *user_data)
+{
+    if (count <= 0) return;
+    if (batch_size < 1) batch_size = 1;
+
+    i32 batch_count = (count + batch_size - 1) / batch_size;
+    if (pool->worker_count == 0 || batch_count == 1) {
+        function(user_data, 0, count, 0);
+        return;
+    }
+
+#if defined(ASTEROIDS_THREADS)
+    pthread_mutex_lock(&pool->mutex);
+    // NOTE: A worker that woke up late for the previous job may still be draining its (empty) batch loop.
+    // It registered itself under this lock, so once it is gone nobody can touch the counters we reset below.
+    while (atomic_load(&pool->active_workers) > 0) {
+        sched_yield();
+    }
+
+    pool->function    = function;
+    pool->user_data   = user_data;
+    pool->count       = count;
+    pool->batch_size  = batch_size;
+    pool->batch_count = batch_count;
+    atomic_store(&pool->next_batch, 0);
+    atomic_store(&pool->finished_batches, 0);
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+
+    RunJobBatches(pool, function, user_data, count, batch_size, batch_count, 0);
+
+    while (atomic_load(&pool->finished_batches) < batch_count || atomic_load(&pool->active_workers) > 0) {
+        sched_yield();
+    }
+#endif
+}
@@ -0,0 +1,45 @@
+#ifndef JOBS_HEADER_GUARD
+#define JOBS_HEADER_GUARD
+
+#include "types.h"
+
+// Threading is opt-in. Desktop builds pass -DASTEROIDS_THREADS (and -pthread), the web build gets it
+// automatically when compiled with emcc -pthread. Without it the pool has no workers and every job runs
+// inline on the calling thread, which is exactly the old single-threaded behaviour.
+#if defined(__EMSCRIPTEN_PTHREADS__) && !defined(ASTEROIDS_THREADS)
+#define ASTEROIDS_THREADS
+#endif
+
+#if defined(ASTEROIDS_THREADS)
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
+
+#define JOB_POOL_MAX_WORKERS 15
+
+// Processes elements [begin, end). worker_index is 0 for the calling thread and 1..worker_count for the pool.
+typedef void (*JobFunction)(void *user_data, i32 begin, i32 end, i32 worker_index);
+
+typedef struct JobPool {
+    i32 worker_count;
+
+#if defined(ASTEROIDS_THREADS)
+    pthread_t       threads[JOB_POOL_MAX_WORKERS];
+    pthread_mutex_t mutex;
+    pthread_cond_t  wake;
+    u32             generation;
+    b32             quit;
+
+    JobFunction function;
+    void       *user_data;
+    i32         count;
+    i32         batch_size;
+    i32         batch_count;
+
+    atomic_int next_batch;
+    atomic_int finished_batches;
+    atomic_int active_workers;
+#endif
+} JobPool;
+
+#endif // JOBS_HEADER_GUARD
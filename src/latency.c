@@ -0,0 +1,167 @@
+#include "latency.h"
+#include "../include/raylib.h"
+#include "../include/raymath.h"
+#include "../include/rlgl.h"
+#include "asteroids.h"
+#include "gl.h"
+#include "profile.h"
+#include "replay.h"
+#include "types.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char *latency_event_names[LATENCY_EVENT_COUNT] = {"aim", "fire"};
+
+#if !defined(PLATFORM_WEB)
+void glfwGetCursorPos(void *window, double *x, double *y);
+#endif
+
+// GetMousePosition is as old as the last PollInputEvents. GLFW asks the OS for the cursor position instead, so this
+// also sees motion since then. The web only gets mouse events between frames, so there is nothing newer to read.
+static Vector2 ReadLatestMousePosition()
+{
+#if defined(PLATFORM_WEB)
+    return GetMousePosition();
+#else
+    double x = 0.0;
+    double y = 0.0;
+    glfwGetCursorPos(GetWindowHandle(), &x, &y);
+    return (Vector2){(f32)x, (f32)y};
+#endif
+}
+
+// Notes the inputs that the frame started at input_time will show
+static void BeginLatencyFrame(LatencyMonitor *monitor, const FrameInput *input, f64 input_time)
+{
+    if (!monitor->active) return;
+
+    b32 fire_down = (input->flags & INPUT_FIRE) != 0;
+    if (fire_down && !monitor->fire_down) {
+        monitor->pending[LATENCY_EVENT_FIRE] = input_time;
+    }
+    monitor->fire_down = fire_down;
+
+    if (!Vector2Equals(input->mouse_position, monitor->aim_position)) {
+        monitor->pending[LATENCY_EVENT_AIM] = input_time;
+        monitor->aim_position               = input->mouse_position;
+    }
+}
+
+// The ship is drawn towards a mouse position sampled after the frame's poll
+static void LatchLatencyAim(LatencyMonitor *monitor, Vector2 mouse_position, f64 sample_time)
+{
+    if (!monitor->active || Vector2Equals(mouse_position, monitor->aim_position)) return;
+
+    monitor->pending[LATENCY_EVENT_AIM] = sample_time;
+    monitor->aim_position               = mouse_position;
+}
+
+// Call once the frame is drawn, as close to its swap as possible
+static void EndLatencyFrame(LatencyMonitor *monitor)
+{
+    if (!monitor->active) return;
+
+    rlDrawRenderBatchActive();
+    glFinish();
+    f64 present_time = GetTime();
+
+    for (i32 i = 0; i < LATENCY_EVENT_COUNT; ++i) {
+        if (monitor->pending[i] == 0.0) continue;
+
+        i32 index                  = monitor->sample_counts[i]++ % LATENCY_SAMPLE_CAPACITY;
+        monitor->samples[i][index] = (f32)((present_time - monitor->pending[i]) * 1000.0);
+        monitor->pending[i]        = 0.0;
+    }
+}
+
+static int CompareF32(const void *a, const void *b)
+{
+    f32 x = *(const f32 *)a;
+    f32 y = *(const f32 *)b;
+    return (x > y) - (x < y);
+}
+
+// Logs the distribution of the latencies measured since the last report and starts over
+static void ReportLatency(LatencyMonitor *monitor, const char *label)
+{
+    if (!monitor->active) return;
+
+    static f32 sorted[LATENCY_SAMPLE_CAPACITY];
+    for (i32 i = 0; i < LATENCY_EVENT_COUNT; ++i) {
+        i32 count = si_min(monitor->sample_counts[i], LATENCY_SAMPLE_CAPACITY);
+        if (count == 0) {
+            TraceLog(LOG_INFO, "LATENCY: %-4s %s: no events", latency_event_names[i], label);
+            continue;
+        }
+
+        memcpy(sorted, monitor->samples[i], count * sizeof(f32));
+        qsort(sorted, count, sizeof(f32), CompareF32);
+
+        f64 sum = 0.0;
+        for (i32 s = 0; s < count; ++s) sum += sorted[s];
+
+        TraceLog(LOG_INFO,
+            "LATENCY: %-4s %s: %d events, mean %.2f ms, p50 %.2f ms, p95 %.2f ms, max %.2f ms",
+            latency_event_names[i],
+            label,
+            count,
+            sum / count,
+            sorted[count / 2],
+            sorted[(count * 95) / 100],
+            sorted[count - 1]);
+        monitor->sample_counts[i] = 0;
+    }
+}
+
+#if defined(ASTEROIDS_CUSTOM_FRAME_CONTROL)
+static void InitializeFrameScheduler(FrameScheduler *scheduler, i32 fps)
+{
+    *scheduler             = (FrameScheduler){};
+    scheduler->period      = (fps > 0) ? 1.0 / fps : 0.0;
+    scheduler->frame_start = GetTime();
+    scheduler->deadline    = scheduler->frame_start;
+}
+
+// Sleeps until the latest time input can be polled for the frame to still be swapped by its deadline, going by the
+// slowest of the recent frames, then polls it
+static void BeginScheduledFrame(FrameScheduler *scheduler)
+{
+    if (scheduler->period > 0.0) {
+        f32 work_time = 0.0f;
+        for (i32 i = 0; i < FRAME_SCHEDULER_HISTORY; ++i) {
+            work_time = si_max(work_time, scheduler->work_times[i]);
+        }
+
+        f64 wake_time = scheduler->deadline - work_time - FRAME_SCHEDULER_MARGIN;
+        f64 now       = GetTime();
+        if (wake_time > now) WaitTime(wake_time - now);
+    }
+
+    PollInputEvents();
+
+    f64 now                = GetTime();
+    scheduler->frame_time  = (f32)(now - scheduler->frame_start);
+    scheduler->frame_start = now;
+}
+
+static void EndScheduledFrame(FrameScheduler *scheduler)
+{
+    PROFILE_ZONE("EndScheduledFrame");
+
+    SwapScreenBuffer();
+
+    f64 present_end = GetTime();
+
+    scheduler->work_times[scheduler->next_work_time] = (f32)(present_end - scheduler->frame_start);
+    scheduler->next_work_time                        = (scheduler->next_work_time + 1) % FRAME_SCHEDULER_HISTORY;
+
+    // NOTE: A swap that returns after its deadline was either late or held until the vertical blank by vsync. The
+    // next deadline is then a period after it, which lines the following swaps up with the blanks.
+    if (present_end > scheduler->deadline) {
+        scheduler->deadline = present_end + scheduler->period;
+    } else {
+        scheduler->deadline += scheduler->period;
+    }
+}
+#endif
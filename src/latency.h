@@ -0,0 +1,56 @@
+#ifndef LATENCY_HEADER_GUARD
+#define LATENCY_HEADER_GUARD
+
+#include "../include/raylib.h"
+#include "types.h"
+
+#if defined(ASTEROIDS_CUSTOM_FRAME_CONTROL) && defined(PLATFORM_WEB)
+#error "The browser schedules frames on the web, build without ASTEROIDS_CUSTOM_FRAME_CONTROL"
+#endif
+
+// Latencies kept per event type; older ones are overwritten
+#define LATENCY_SAMPLE_CAPACITY 4096
+
+#if defined(ASTEROIDS_CUSTOM_FRAME_CONTROL)
+// Frames whose poll-to-present time the frame scheduler predicts the next one from, and the slack it leaves
+#define FRAME_SCHEDULER_HISTORY 16
+#define FRAME_SCHEDULER_MARGIN 0.002
+#endif
+
+typedef enum LatencyEventNames {
+    LATENCY_EVENT_AIM,  // Mouse moved, shown by the ship's orientation
+    LATENCY_EVENT_FIRE, // Fire pressed, shown by the first bullet
+    LATENCY_EVENT_COUNT,
+} LatencyEventNames;
+
+// Measures how old the input a frame shows is by the time that frame is presented. Every input is timestamped when
+// it is sampled (the frame's poll, or the late latch for aim) and the latency is taken once the GPU has finished the
+// frame drawing it. With custom frame control that is after the swap; otherwise raylib's EndDrawing sleeps between
+// the swap and the next poll, so it is taken just before EndDrawing and doesn't include a swap held by vsync. The
+// time the display then takes to scan the frame out isn't included either way.
+typedef struct LatencyMonitor {
+    b32 active;
+
+    f64     pending[LATENCY_EVENT_COUNT]; // Sample time of an input the next present shows, 0 for none
+    Vector2 aim_position;                 // Mouse position of the last aim event
+    b32     fire_down;
+
+    f32 samples[LATENCY_EVENT_COUNT][LATENCY_SAMPLE_CAPACITY]; // Milliseconds
+    i32 sample_counts[LATENCY_EVENT_COUNT];
+} LatencyMonitor;
+
+#if defined(ASTEROIDS_CUSTOM_FRAME_CONTROL)
+// Sleeps at the start of a frame instead of after presenting it, so input is polled as late as the predicted frame
+// time allows. Needs a raylib built with SUPPORT_CUSTOM_FRAME_CONTROL, where EndDrawing neither swaps nor polls.
+typedef struct FrameScheduler {
+    f64 period;      // Seconds per frame, 0 for no limit
+    f64 frame_start; // When input was last polled
+    f64 deadline;    // When the frame being made should be swapped
+    f32 frame_time;  // Between the last two polls, the dt of the frame
+
+    f32 work_times[FRAME_SCHEDULER_HISTORY]; // Poll to swap of recent frames
+    i32 next_work_time;
+} FrameScheduler;
+#endif
+
+#endif // LATENCY_HEADER_GUARD
@@ -0,0 +1,200 @@
+#include "profile.h"
+#include "../include/raylib.h"
+#include "types.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(ASTEROIDS_PROFILE)
+static ProfileRing profile_rings[PROFILE_MAX_THREADS];
+
+// Ring of the calling thread: -1 while it has none, PROFILE_MAX_THREADS once there were none left for it
+static _Thread_local i32 profile_thread_ring = -1;
+
+static u64 ReadProfileClock()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ull + (u64)now.tv_nsec;
+}
+
+// Takes the ring a thread of the same name gave back, so e.g. every capture writer records on one track, else an
+// unused ring, else any ring given back (dropping the events of its previous thread). Returns -1 if all are claimed.
+static i32 ClaimProfileRing(const char *thread_name)
+{
+    for (i32 pass = 0; pass < 3; ++pass) {
+        for (i32 r = 0; r < PROFILE_MAX_THREADS; ++r) {
+            ProfileRing *ring     = &profile_rings[r];
+            i32          expected = (pass == 1) ? PROFILE_RING_UNUSED : PROFILE_RING_RELEASED;
+            if (atomic_load(&ring->state) != expected) continue;
+            if (pass == 0 && (!thread_name || strcmp(ring->thread_name, thread_name) != 0)) continue;
+            if (!atomic_compare_exchange_strong(&ring->state, &expected, PROFILE_RING_CLAIMED)) continue;
+
+            if (pass == 2) {
+                ring->thread_name[0] = '\0';
+                atomic_store(&ring->head, 0);
+            }
+            return r;
+        }
+    }
+    return -1;
+}
+
+static void AssignProfileRing(const char *thread_name)
+{
+    i32 ring = ClaimProfileRing(thread_name);
+    if (ring < 0) {
+        TraceLog(LOG_WARNING,
+            "PROFILE: No ring left for %s, its events are dropped (raise PROFILE_MAX_THREADS)",
+            thread_name ? thread_name : "a thread");
+        ring = PROFILE_MAX_THREADS;
+    }
+    profile_thread_ring = ring;
+}
+
+static ProfileRing *GetProfileRing()
+{
+    if (profile_thread_ring < 0) AssignProfileRing(NULL);
+    return (profile_thread_ring < PROFILE_MAX_THREADS) ? &profile_rings[profile_thread_ring] : NULL;
+}
+
+// Shown as the calling thread's name in the trace, "<name> <number>" unless number is negative. Called first thing
+// by a thread, so it can take back the ring of an earlier thread with the same name.
+static void NameProfileThread(const char *name, i32 number)
+{
+    char thread_name[sizeof(profile_rings[0].thread_name)];
+    if (number >= 0) {
+        snprintf(thread_name, sizeof(thread_name), "%s %d", name, number);
+    } else {
+        snprintf(thread_name, sizeof(thread_name), "%s", name);
+    }
+
+    if (profile_thread_ring < 0) AssignProfileRing(thread_name);
+    ProfileRing *ring = GetProfileRing();
+    if (!ring) return;
+
+    memcpy(ring->thread_name, thread_name, sizeof(thread_name));
+}
+
+#if defined(ASTEROIDS_THREADS)
+// Called last thing by a thread that exits, its events stay in the trace until another thread takes the ring
+static void ReleaseProfileThread()
+{
+    if (profile_thread_ring >= 0 && profile_thread_ring < PROFILE_MAX_THREADS) {
+        atomic_store(&profile_rings[profile_thread_ring].state, PROFILE_RING_RELEASED);
+    }
+    profile_thread_ring = -1;
+}
+#endif
+
+static void RecordProfileEvent(const char *name, u64 time, ProfileEventKind kind, u32 value)
+{
+    ProfileRing *ring = GetProfileRing();
+    if (!ring) return;
+
+    // NOTE: PROFILE_RING_CAPACITY divides 2^32, so the slots stay in order when head wraps around
+    u32 head                                   = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    ring->events[head % PROFILE_RING_CAPACITY] = (ProfileEvent){name, time, kind, value};
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+static ProfileZone BeginProfileZone(const char *name)
+{
+    return (ProfileZone){name, ReadProfileClock()};
+}
+
+static void EndProfileZone(ProfileZone *zone)
+{
+    u64 duration = ReadProfileClock() - zone->begin;
+    RecordProfileEvent(zone->name, zone->begin, PROFILE_EVENT_ZONE, (duration < UINT32_MAX) ? (u32)duration : UINT32_MAX);
+}
+
+static void RecordProfileCounter(const char *name, i32 value)
+{
+    RecordProfileEvent(name, ReadProfileClock(), PROFILE_EVENT_COUNTER, (u32)value);
+}
+
+// Writes the events every thread still has in its ring as a Chrome trace (JSON Object Format), which
+// ui.perfetto.dev and chrome://tracing open. Returns the event count, or -1 if the file couldn't be written. Meant
+// to run while the other threads are idle; a thread that records meanwhile may overwrite its oldest events, and
+// those are left out.
+static i32 WriteProfileTrace(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file) return -1;
+
+    // Timestamps start at the oldest event kept
+    u64 origin = UINT64_MAX;
+    for (i32 r = 0; r < PROFILE_MAX_THREADS; ++r) {
+        ProfileRing *ring = &profile_rings[r];
+        u32          head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        for (u32 i = (head > PROFILE_RING_CAPACITY) ? head - PROFILE_RING_CAPACITY : 0; i != head; ++i) {
+            u64 time = ring->events[i % PROFILE_RING_CAPACITY].time;
+            origin   = (time < origin) ? time : origin;
+        }
+    }
+
+    i32 count        = 0;
+    i32 thread_count = 0;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (i32 r = 0; r < PROFILE_MAX_THREADS; ++r) {
+        ProfileRing *ring = &profile_rings[r];
+        if (atomic_load(&ring->state) == PROFILE_RING_UNUSED) continue;
+
+        fprintf(file,
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            (thread_count++ > 0) ? ",\n" : "",
+            r,
+            ring->thread_name[0] ? ring->thread_name : "thread");
+
+        // NOTE: The slot after the newest event is the next one written, so the oldest event is only safe to read
+        // while the thread is idle. It is left out either way, which keeps the check below simple.
+        u32 head  = atomic_load_explicit(&ring->head, memory_order_acquire);
+        u32 first = (head > PROFILE_RING_CAPACITY - 1) ? head - (PROFILE_RING_CAPACITY - 1) : 0;
+        for (u32 i = first; i != head; ++i) {
+            ProfileEvent event = ring->events[i % PROFILE_RING_CAPACITY];
+
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&ring->head, memory_order_relaxed) - i >= PROFILE_RING_CAPACITY) continue;
+
+            f64 timestamp = (event.time - origin) / 1000.0;
+            if (event.kind == PROFILE_EVENT_ZONE) {
+                fprintf(file,
+                    ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    event.name,
+                    r,
+                    timestamp,
+                    event.value / 1000.0);
+            } else {
+                fprintf(file,
+                    ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%d}}",
+                    event.name,
+                    r,
+                    timestamp,
+                    (i32)event.value);
+            }
+            count++;
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    b32 written = !ferror(file);
+    written     = (fclose(file) == 0) && written;
+    return written ? count : -1;
+}
+
+// F7 and quitting write the recent history to trace_<time>.json
+static void DumpProfileTrace()
+{
+    char path[64];
+    snprintf(path, sizeof(path), "trace_%lld.json", (long long)time(NULL));
+
+    i32 count = WriteProfileTrace(path);
+    if (count < 0) {
+        TraceLog(LOG_WARNING, "PROFILE: Could not write %s", path);
+    } else {
+        TraceLog(LOG_INFO, "PROFILE: Wrote %d events to %s", count, path);
+    }
+}
+#endif
@@ -0,0 +1,71 @@
+#ifndef PROFILE_HEADER_GUARD
+#define PROFILE_HEADER_GUARD
+
+#include "jobs.h"
+#include "types.h"
+
+// Instrumentation is opt-in: builds with -DASTEROIDS_PROFILE record timed zones and counters, everything else
+// compiles the macros below away. A zone costs two clock reads and one ring write, so it can stay on in release
+// builds; F7 (and quitting) writes the recent history as a Chrome/Perfetto trace.
+#if defined(ASTEROIDS_PROFILE)
+#include <stdatomic.h>
+#endif
+
+// Events kept per thread, about 5 seconds of a frame's zones and counters at 60 fps; older ones are overwritten
+#define PROFILE_RING_CAPACITY 8192
+
+// The main thread, the job pool workers and the capture writer. A thread gives its ring back when it exits, so a
+// later capture writer records into the ring the previous one used.
+#define PROFILE_MAX_THREADS (JOB_POOL_MAX_WORKERS + 2)
+
+typedef enum ProfileEventKind {
+    PROFILE_EVENT_ZONE,
+    PROFILE_EVENT_COUNTER,
+} ProfileEventKind;
+
+typedef enum ProfileRingState {
+    PROFILE_RING_UNUSED,
+    PROFILE_RING_CLAIMED,  // Owned by a running thread
+    PROFILE_RING_RELEASED, // Its thread exited, the events stay in the trace until another thread takes the ring
+} ProfileRingState;
+
+typedef struct ProfileEvent {
+    const char *name;  // Never copied, so a string literal or other static string
+    u64         time;  // Nanoseconds since the profiler started, when a zone began or a counter was sampled
+    u32         kind;  // ProfileEventKind
+    u32         value; // Duration in nanoseconds of a zone, value of a counter
+} ProfileEvent;
+
+#if defined(ASTEROIDS_PROFILE)
+// Written by the thread that claimed it only. The head is published after the event, so a reader that loads it sees
+// every event before it.
+typedef struct ProfileRing {
+    char         thread_name[32];
+    atomic_int   state; // ProfileRingState
+    atomic_uint  head;  // Events written so far, the next one goes to head % PROFILE_RING_CAPACITY
+    ProfileEvent events[PROFILE_RING_CAPACITY];
+} ProfileRing;
+
+typedef struct ProfileZone {
+    const char *name;
+    u64         begin;
+} ProfileZone;
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// Times the rest of the enclosing block
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profile_, __LINE__) __attribute__((cleanup(EndProfileZone))) = BeginProfileZone(name)
+#define PROFILE_COUNTER(name, value) RecordProfileCounter(name, value)
+#define PROFILE_THREAD_NAME(name, number) NameProfileThread(name, number)
+#define PROFILE_THREAD_END() ReleaseProfileThread()
+#else
+// NOTE: sizeof keeps the arguments referenced without evaluating them, so values only computed for the profiler
+// don't warn as unused
+#define PROFILE_ZONE(name) ((void)sizeof(name))
+#define PROFILE_COUNTER(name, value) ((void)sizeof(value))
+#define PROFILE_THREAD_NAME(name, number) ((void)sizeof(number))
+#define PROFILE_THREAD_END() ((void)0)
+#endif
+
+#endif // PROFILE_HEADER_GUARD
@@ -0,0 +1,72 @@
+#include "render_target.h"
+#include "../include/raylib.h"
+#include "gl.h"
+#include "types.h"
+
+#include <string.h>
+
+static const char *render_target_format_names[RENDER_TARGET_FORMAT_COUNT] = {"rgba8", "r11g11b10f", "rgba16f"};
+static const i32   render_target_format_sizes[RENDER_TARGET_FORMAT_COUNT] = {4, 4, 8};
+
+static const char *render_pass_names[RENDER_PASS_COUNT] = {"scene", "fxaa", "bloom"};
+
+// Returns -1 for an unknown name
+static i32 ParseRenderTargetFormat(const char *name)
+{
+    for (i32 i = 0; i < RENDER_TARGET_FORMAT_COUNT; ++i) {
+        if (strcmp(name, render_target_format_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static i32 GetRenderTargetSize(RenderTexture2D target, RenderTargetFormat format)
+{
+    return target.texture.width * target.texture.height * render_target_format_sizes[format];
+}
+
+// Like LoadRenderTexture, but with a float color buffer for the HDR formats. Falls back to RGBA8 (and changes
+// *format to match) when the GPU can't render to the requested format.
+static RenderTexture2D LoadRenderTargetWithFormat(i32 width, i32 height, RenderTargetFormat *format)
+{
+    if (*format != RENDER_TARGET_FORMAT_RGBA8 && LoadGLFunctions()) {
+        b32 packed = (*format == RENDER_TARGET_FORMAT_R11G11B10F);
+
+        RenderTexture2D target = {};
+        target.texture.width   = width;
+        target.texture.height  = height;
+        target.texture.mipmaps = 1;
+        // NOTE: Only used by raylib for CPU readbacks; it has no packed float format
+        target.texture.format = packed ? PIXELFORMAT_UNCOMPRESSED_R16G16B16 : PIXELFORMAT_UNCOMPRESSED_R16G16B16A16;
+
+        glGenTextures(1, &target.texture.id);
+        glBindTexture(GL_TEXTURE_2D, target.texture.id);
+        glTexImage2D(GL_TEXTURE_2D,
+            0,
+            packed ? GL_R11F_G11F_B10F : GL_RGBA16F,
+            width,
+            height,
+            0,
+            packed ? GL_RGB : GL_RGBA,
+            GL_HALF_FLOAT,
+            NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &target.id);
+        glBindFramebuffer(GL_FRAMEBUFFER, target.id);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture.id, 0);
+        b32 complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        if (complete) return target;
+
+        TraceLog(LOG_WARNING, "RENDER: %s targets are not supported, using rgba8", render_target_format_names[*format]);
+        UnloadRenderTexture(target);
+    }
+
+    *format = RENDER_TARGET_FORMAT_RGBA8;
+    return LoadRenderTexture(width, height);
+}
@@ -0,0 +1,32 @@
+#ifndef RENDER_TARGET_HEADER_GUARD
+#define RENDER_TARGET_HEADER_GUARD
+
+#include "../include/raylib.h"
+#include "types.h"
+
+typedef enum RenderTargetFormat {
+    RENDER_TARGET_FORMAT_RGBA8,      // 4 bytes, clamped to [0, 1]
+    RENDER_TARGET_FORMAT_R11G11B10F, // 4 bytes, packed unsigned floats, no alpha
+    RENDER_TARGET_FORMAT_RGBA16F,    // 8 bytes, half floats
+    RENDER_TARGET_FORMAT_COUNT,
+} RenderTargetFormat;
+
+// Passes whose targets can hold HDR values
+typedef enum RenderPassNames {
+    RENDER_PASS_SCENE, // Geometry, render_targets[0]
+    RENDER_PASS_FXAA,  // Anti-aliased scene, render_targets[1], also the bloom source
+    RENDER_PASS_BLOOM, // Downsample and blur chain
+    RENDER_PASS_COUNT,
+} RenderPassNames;
+
+// Packed HDR costs the same bandwidth as RGBA8. The web stays on RGBA8 by default since rendering to float
+// targets needs EXT_color_buffer_float there; unsupported formats fall back to RGBA8 either way.
+#ifndef DEFAULT_RENDER_TARGET_FORMAT
+#if defined(PLATFORM_WEB)
+#define DEFAULT_RENDER_TARGET_FORMAT RENDER_TARGET_FORMAT_RGBA8
+#else
+#define DEFAULT_RENDER_TARGET_FORMAT RENDER_TARGET_FORMAT_R11G11B10F
+#endif
+#endif
+
+#endif // RENDER_TARGET_HEADER_GUARD
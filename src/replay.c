@@ -0,0 +1,100 @@
+#include "replay.h"
+#include "../include/raylib.h"
+#include "types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static FrameInput ReadFrameInput()
+{
+    FrameInput input = {
+        .dt             = GetFrameTime(),
+        .mouse_position = GetMousePosition(),
+        .flags          = 0,
+    };
+
+    if (IsKeyDown(KEY_SPACE) || IsMouseButtonDown(0)) input.flags |= INPUT_FIRE;
+    if (IsKeyDown(KEY_W) || IsKeyDown(KEY_UP)) input.flags |= INPUT_UP;
+    if (IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN)) input.flags |= INPUT_DOWN;
+    if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT)) input.flags |= INPUT_LEFT;
+    if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) input.flags |= INPUT_RIGHT;
+    if (IsKeyPressed(KEY_SPACE)) input.flags |= INPUT_RESTART;
+    if (IsKeyPressed(KEY_P)) input.flags |= INPUT_PAUSE;
+    if (IsKeyPressed(KEY_F)) input.flags |= INPUT_TOGGLE_FPS;
+    if (!IsWindowFocused()) input.flags |= INPUT_FOCUS_LOST;
+
+    return input;
+}
+
+static void BeginReplayRecording(Replay *replay, u64 seed, i32 screen_width, i32 screen_height, i32 fps)
+{
+    replay->header = (ReplayHeader){
+        .magic         = REPLAY_FILE_MAGIC,
+        .version       = REPLAY_FILE_VERSION,
+        .seed          = seed,
+        .screen_width  = screen_width,
+        .screen_height = screen_height,
+        .fps           = fps,
+        .frame_count   = 0,
+    };
+    replay->cursor = 0;
+}
+
+static void RecordFrameInput(Replay *replay, FrameInput input)
+{
+    if (replay->header.frame_count == replay->capacity) {
+        i32         capacity = (replay->capacity > 0) ? replay->capacity * 2 : 4096;
+        FrameInput *frames   = realloc(replay->frames, sizeof(FrameInput) * capacity);
+        if (!frames) return;
+
+        replay->frames   = frames;
+        replay->capacity = capacity;
+    }
+
+    replay->frames[replay->header.frame_count++] = input;
+}
+
+static b32 SaveReplay(Replay *replay, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+
+    b32 ok = fwrite(&replay->header, sizeof(replay->header), 1, file) == 1;
+    ok     = ok && fwrite(replay->frames, sizeof(FrameInput), replay->header.frame_count, file) == (size_t)replay->header.frame_count;
+    fclose(file);
+    return ok;
+}
+
+static b32 LoadReplay(Replay *replay, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    b32 ok = fread(&replay->header, sizeof(replay->header), 1, file) == 1;
+    ok     = ok && replay->header.magic == REPLAY_FILE_MAGIC && replay->header.version == REPLAY_FILE_VERSION;
+    ok     = ok && replay->header.frame_count >= 0;
+
+    if (ok) {
+        replay->capacity = replay->header.frame_count;
+        replay->frames   = malloc(sizeof(FrameInput) * (replay->capacity + 1));
+        ok = replay->frames && fread(replay->frames, sizeof(FrameInput), replay->capacity, file) == (size_t)replay->capacity;
+    }
+    fclose(file);
+
+    replay->cursor = 0;
+    return ok;
+}
+
+static b32 NextReplayFrame(Replay *replay, FrameInput *input)
+{
+    if (replay->cursor >= replay->header.frame_count) return false;
+
+    *input = replay->frames[replay->cursor++];
+    return true;
+}
+
+static void UnloadReplay(Replay *replay)
+{
+    free(replay->frames);
+    *replay = (Replay){};
+}
@@ -0,0 +1,47 @@
+#ifndef REPLAY_HEADER_GUARD
+#define REPLAY_HEADER_GUARD
+
+#include "../include/raylib.h"
+#include "types.h"
+
+enum FrameInputFlags {
+    INPUT_FIRE       = 1 << 0, // Space or left mouse button held
+    INPUT_UP         = 1 << 1,
+    INPUT_DOWN       = 1 << 2,
+    INPUT_LEFT       = 1 << 3,
+    INPUT_RIGHT      = 1 << 4,
+    INPUT_RESTART    = 1 << 5, // Space pressed this frame
+    INPUT_PAUSE      = 1 << 6,
+    INPUT_TOGGLE_FPS = 1 << 7,
+    INPUT_FOCUS_LOST = 1 << 8,
+};
+
+// Everything Update reads from the platform in one frame. Together with the seed and the screen size this is
+// enough to replay a session exactly.
+typedef struct FrameInput {
+    f32     dt;
+    Vector2 mouse_position; // Screen space
+    u32     flags;
+} FrameInput;
+
+#define REPLAY_FILE_MAGIC 0x59504552 // "REPY"
+#define REPLAY_FILE_VERSION 1
+
+typedef struct ReplayHeader {
+    u32 magic;
+    u32 version;
+    u64 seed;
+    i32 screen_width;
+    i32 screen_height;
+    i32 fps;
+    i32 frame_count;
+} ReplayHeader;
+
+typedef struct Replay {
+    ReplayHeader header;
+    FrameInput  *frames;
+    i32          capacity;
+    i32          cursor; // Next frame handed out while playing back
+} Replay;
+
+#endif // REPLAY_HEADER_GUARD
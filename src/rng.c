@@ -0,0 +1,179 @@
+#include "rng.h"
+#include "../include/raylib.h"
+#include "asteroids.h"
+#include "simd.h"
+#include "types.h"
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+
+#define RANDOM_NO_BLOCK UINT64_MAX
+
+// One Philox4x32-10 block: 4 outputs for counter (block, stream, substream)
+static void Philox4x32(const RandomStream *rng, u64 block, u32 out[4])
+{
+    u32 c0 = (u32)block;
+    u32 c1 = (u32)(block >> 32);
+    u32 c2 = rng->stream;
+    u32 c3 = rng->substream;
+    u32 k0 = rng->key[0];
+    u32 k1 = rng->key[1];
+
+    for (i32 round = 0; round < 10; ++round) {
+        u64 p0 = (u64)PHILOX_M0 * c0;
+        u64 p1 = (u64)PHILOX_M1 * c2;
+
+        c0 = (u32)(p1 >> 32) ^ c1 ^ k0;
+        c1 = (u32)p1;
+        c2 = (u32)(p0 >> 32) ^ c3 ^ k1;
+        c3 = (u32)p0;
+
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+// Four consecutive blocks at once, one per SIMD lane. out[w * 4 + lane] is word w of block (first_block + lane).
+static void Philox4x32Wide(const RandomStream *rng, u64 first_block, u32 out[16])
+{
+    u32x4 c0 = U32x4Set((u32)first_block, (u32)(first_block + 1), (u32)(first_block + 2), (u32)(first_block + 3));
+    u32x4 c1 = U32x4Set(
+        (u32)(first_block >> 32), (u32)((first_block + 1) >> 32), (u32)((first_block + 2) >> 32), (u32)((first_block + 3) >> 32));
+    u32x4 c2 = U32x4Set1(rng->stream);
+    u32x4 c3 = U32x4Set1(rng->substream);
+    u32   k0 = rng->key[0];
+    u32   k1 = rng->key[1];
+
+    for (i32 round = 0; round < 10; ++round) {
+        u32x4 hi0, lo0, hi1, lo1;
+        U32x4MulWide(c0, PHILOX_M0, &hi0, &lo0);
+        U32x4MulWide(c2, PHILOX_M1, &hi1, &lo1);
+
+        c0 = U32x4Xor(U32x4Xor(hi1, c1), U32x4Set1(k0));
+        c1 = lo1;
+        c2 = U32x4Xor(U32x4Xor(hi0, c3), U32x4Set1(k1));
+        c3 = lo0;
+
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    U32x4Store(out + 0, c0);
+    U32x4Store(out + 4, c1);
+    U32x4Store(out + 8, c2);
+    U32x4Store(out + 12, c3);
+}
+
+static inline f32 U32ToFloat01(u32 x)
+{
+    return (f32)(x >> 8) * (1.0f / 16777216.0f);
+}
+
+static RandomStream CreateRandomStream(u64 seed, u32 stream)
+{
+    RandomStream rng = {
+        .key          = {(u32)seed, (u32)(seed >> 32)},
+        .stream       = stream,
+        .substream    = 0,
+        .index        = 0,
+        .cached_block = RANDOM_NO_BLOCK,
+    };
+    return rng;
+}
+
+#if defined(ASTEROIDS_HEADLESS)
+// Child stream for a sub-system or thread; independent of the parent and of siblings with another id. The game seeds
+// every system with its own stream instead, so only the headless benchmark uses this.
+static RandomStream SplitRandomStream(const RandomStream *parent, u32 id)
+{
+    RandomStream rng = *parent;
+    rng.substream    = (parent->substream ^ PHILOX_W0) * PHILOX_M0 + id + 1;
+    rng.index        = 0;
+    rng.cached_block = RANDOM_NO_BLOCK;
+    return rng;
+}
+#endif
+
+static u32 GetRandomU32At(const RandomStream *rng, u64 index)
+{
+    u32 block[4];
+    Philox4x32(rng, index >> 2, block);
+    return block[index & 3];
+}
+
+static u32 NextRandomU32(RandomStream *rng)
+{
+    u64 block = rng->index >> 2;
+    if (block != rng->cached_block) {
+        Philox4x32(rng, block, rng->cache);
+        rng->cached_block = block;
+    }
+    return rng->cache[rng->index++ & 3];
+}
+
+static f32 NextRandomFloat01(RandomStream *rng)
+{
+    return U32ToFloat01(NextRandomU32(rng));
+}
+
+static f32 NextRandomFloatRange(RandomStream *rng, f32 min, f32 max)
+{
+    return min + (max - min) * NextRandomFloat01(rng);
+}
+
+// Inclusive on both ends, like raylib's GetRandomValue
+static i32 NextRandomInt(RandomStream *rng, i32 min, i32 max)
+{
+    u64 range = (u64)((i64)max - (i64)min) + 1;
+    return (i32)((i64)min + (i64)(((u64)NextRandomU32(rng) * range) >> 32));
+}
+
+// Claims count values from the sequential position for a batch fill, e.g. one shared by several threads
+static u64 ReserveRandomValues(RandomStream *rng, u64 count)
+{
+    u64 first = rng->index;
+    rng->index += count;
+    return first;
+}
+
+// Values [first_index, first_index + count) of the stream as floats in [0, 1)
+static void FillRandomFloat01(const RandomStream *rng, u64 first_index, i32 count, f32 *out)
+{
+    i32 i = 0;
+
+    // Scalar until the index is at a 16 value (4 block) boundary
+    while (i < count && ((first_index + i) & 15) != 0) {
+        out[i] = U32ToFloat01(GetRandomU32At(rng, first_index + i));
+        i++;
+    }
+
+    for (; i + 16 <= count; i += 16) {
+        u32 words[16];
+        Philox4x32Wide(rng, (first_index + i) >> 2, words);
+
+        // Back from lane-major to index order: value (block * 4 + word) lives at words[word * 4 + block]
+        for (i32 w = 0; w < 4; ++w) {
+            f32 values[4];
+            F32x4Store(values, U32x4ToFloat01(U32x4Set(words[w * 4 + 0], words[w * 4 + 1], words[w * 4 + 2], words[w * 4 + 3])));
+            for (i32 b = 0; b < 4; ++b) {
+                out[i + b * 4 + w] = values[b];
+            }
+        }
+    }
+
+    for (; i < count; ++i) {
+        out[i] = U32ToFloat01(GetRandomU32At(rng, first_index + i));
+    }
+}
+
+static void NextRandomFloats01(RandomStream *rng, f32 *out, i32 count)
+{
+    FillRandomFloat01(rng, ReserveRandomValues(rng, count), count, out);
+}
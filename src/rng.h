@@ -0,0 +1,19 @@
+#ifndef RNG_HEADER_GUARD
+#define RNG_HEADER_GUARD
+
+#include "types.h"
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+// Every value is a pure function of (seed, stream, substream, index): streams share no state, and a batch
+// filled by any number of threads is identical to drawing the same indices one by one.
+typedef struct RandomStream {
+    u32 key[2];
+    u32 stream;
+    u32 substream;
+
+    u64 index; // Next value handed out by the sequential Next* functions
+    u64 cached_block;
+    u32 cache[4];
+} RandomStream;
+
+#endif // RNG_HEADER_GUARD
@@ -0,0 +1,187 @@
+#ifndef SIMD_HEADER_GUARD
+#define SIMD_HEADER_GUARD
+
+#include "types.h"
+
+// Minimal 4-wide float vector used by the hot simulation loops. The same code path runs as WebAssembly
+// SIMD (-msimd128), SSE2 on desktop, or plain scalar code when neither is available.
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define SIMD_ENABLED 1
+typedef v128_t f32x4;
+typedef v128_t u32x4;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMD_ENABLED 1
+typedef __m128  f32x4;
+typedef __m128i u32x4;
+#else
+#define SIMD_ENABLED 0
+typedef struct f32x4 {
+    f32 e[4];
+} f32x4;
+typedef struct u32x4 {
+    u32 e[4];
+} u32x4;
+#endif
+
+static inline f32x4 F32x4Load(const f32 *p)
+{
+#if defined(__wasm_simd128__)
+    return wasm_v128_load(p);
+#elif SIMD_ENABLED
+    return _mm_loadu_ps(p);
+#else
+    return (f32x4){{p[0], p[1], p[2], p[3]}};
+#endif
+}
+
+static inline void F32x4Store(f32 *p, f32x4 v)
+{
+#if defined(__wasm_simd128__)
+    wasm_v128_store(p, v);
+#elif SIMD_ENABLED
+    _mm_storeu_ps(p, v);
+#else
+    for (i32 i = 0; i < 4; ++i) p[i] = v.e[i];
+#endif
+}
+
+static inline f32x4 F32x4Set(f32 a, f32 b, f32 c, f32 d)
+{
+#if defined(__wasm_simd128__)
+    return wasm_f32x4_make(a, b, c, d);
+#elif SIMD_ENABLED
+    return _mm_setr_ps(a, b, c, d);
+#else
+    return (f32x4){{a, b, c, d}};
+#endif
+}
+
+static inline f32x4 F32x4Add(f32x4 a, f32x4 b)
+{
+#if defined(__wasm_simd128__)
+    return wasm_f32x4_add(a, b);
+#elif SIMD_ENABLED
+    return _mm_add_ps(a, b);
+#else
+    return (f32x4){{a.e[0] + b.e[0], a.e[1] + b.e[1], a.e[2] + b.e[2], a.e[3] + b.e[3]}};
+#endif
+}
+
+static inline f32x4 F32x4Mul(f32x4 a, f32x4 b)
+{
+#if defined(__wasm_simd128__)
+    return wasm_f32x4_mul(a, b);
+#elif SIMD_ENABLED
+    return _mm_mul_ps(a, b);
+#else
+    return (f32x4){{a.e[0] * b.e[0], a.e[1] * b.e[1], a.e[2] * b.e[2], a.e[3] * b.e[3]}};
+#endif
+}
+
+// (x0, y0, x1, y1) -> (y0, x0, y1, x1)
+static inline f32x4 F32x4SwapPairs(f32x4 v)
+{
+#if defined(__wasm_simd128__)
+    return wasm_i32x4_shuffle(v, v, 1, 0, 3, 2);
+#elif SIMD_ENABLED
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+#else
+    return (f32x4){{v.e[1], v.e[0], v.e[3], v.e[2]}};
+#endif
+}
+
+static inline u32x4 U32x4Set(u32 a, u32 b, u32 c, u32 d)
+{
+#if defined(__wasm_simd128__)
+    return wasm_u32x4_make(a, b, c, d);
+#elif SIMD_ENABLED
+    return _mm_setr_epi32((i32)a, (i32)b, (i32)c, (i32)d);
+#else
+    return (u32x4){{a, b, c, d}};
+#endif
+}
+
+static inline u32x4 U32x4Set1(u32 a)
+{
+    return U32x4Set(a, a, a, a);
+}
+
+static inline void U32x4Store(u32 *p, u32x4 v)
+{
+#if defined(__wasm_simd128__)
+    wasm_v128_store(p, v);
+#elif SIMD_ENABLED
+    _mm_storeu_si128((__m128i *)p, v);
+#else
+    for (i32 i = 0; i < 4; ++i) p[i] = v.e[i];
+#endif
+}
+
+static inline u32x4 U32x4Add(u32x4 a, u32x4 b)
+{
+#if defined(__wasm_simd128__)
+    return wasm_i32x4_add(a, b);
+#elif SIMD_ENABLED
+    return _mm_add_epi32(a, b);
+#else
+    return (u32x4){{a.e[0] + b.e[0], a.e[1] + b.e[1], a.e[2] + b.e[2], a.e[3] + b.e[3]}};
+#endif
+}
+
+static inline u32x4 U32x4Xor(u32x4 a, u32x4 b)
+{
+#if defined(__wasm_simd128__)
+    return wasm_v128_xor(a, b);
+#elif SIMD_ENABLED
+    return _mm_xor_si128(a, b);
+#else
+    return (u32x4){{a.e[0] ^ b.e[0], a.e[1] ^ b.e[1], a.e[2] ^ b.e[2], a.e[3] ^ b.e[3]}};
+#endif
+}
+
+// Full 32x32 -> 64 bit product of every lane with m, split into high and low halves
+static inline void U32x4MulWide(u32x4 a, u32 m, u32x4 *hi, u32x4 *lo)
+{
+#if defined(__wasm_simd128__)
+    u32x4 mv    = wasm_u32x4_splat(m);
+    u32x4 prod0 = wasm_u64x2_extmul_low_u32x4(a, mv);  // lo0, hi0, lo1, hi1
+    u32x4 prod1 = wasm_u64x2_extmul_high_u32x4(a, mv); // lo2, hi2, lo3, hi3
+    *lo         = wasm_i32x4_shuffle(prod0, prod1, 0, 2, 4, 6);
+    *hi         = wasm_i32x4_shuffle(prod0, prod1, 1, 3, 5, 7);
+#elif SIMD_ENABLED
+    __m128i mv   = _mm_set1_epi32((i32)m);
+    __m128i even = _mm_mul_epu32(a, mv);                    // lo0, hi0, lo2, hi2
+    __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), mv); // lo1, hi1, lo3, hi3
+    __m128i lo02 = _mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0));
+    __m128i lo13 = _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0));
+    __m128i hi02 = _mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 3, 1));
+    __m128i hi13 = _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 3, 1));
+    *lo          = _mm_unpacklo_epi32(lo02, lo13);
+    *hi          = _mm_unpacklo_epi32(hi02, hi13);
+#else
+    for (i32 i = 0; i < 4; ++i) {
+        u64 product = (u64)a.e[i] * m;
+        lo->e[i]    = (u32)product;
+        hi->e[i]    = (u32)(product >> 32);
+    }
+#endif
+}
+
+// Top 24 bits of every lane as a float in [0, 1)
+static inline f32x4 U32x4ToFloat01(u32x4 a)
+{
+#if defined(__wasm_simd128__)
+    return wasm_f32x4_mul(wasm_f32x4_convert_i32x4(wasm_u32x4_shr(a, 8)), wasm_f32x4_splat(1.0f / 16777216.0f));
+#elif SIMD_ENABLED
+    return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(a, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+#else
+    f32x4 r;
+    for (i32 i = 0; i < 4; ++i) r.e[i] = (f32)(a.e[i] >> 8) * (1.0f / 16777216.0f);
+    return r;
+#endif
+}
+
+#endif // SIMD_HEADER_GUARD
@@ -0,0 +1,177 @@
+#include "asteroids.h"
+#include "sweep_and_prune.h"
+#include "types.h"
+
+#include <stdlib.h>
+
+typedef void (*SweepPairFunction)(void *user_data, i32 a, i32 b);
+
+static void ResetSweepAndPrune(SweepAndPrune *sap)
+{
+    sap->current        = 0;
+    sap->endpoint_count = 0;
+    sap->bucket_count   = 0;
+    sap->pair_tests     = 0;
+}
+
+// Called when an asteroid is pushed at index; it gets inserted on the next update.
+static void SweepAndPruneAdd(SweepAndPrune *sap, i32 index)
+{
+    sap->slots[index * 2 + 0] = -1;
+    sap->slots[index * 2 + 1] = -1;
+}
+
+// Mirrors the swap-remove of the asteroid buffer: index is dropped and last takes its place.
+static void SweepAndPruneRemove(SweepAndPrune *sap, i32 index, i32 last)
+{
+    SweepEndpoint *endpoints = sap->endpoints[sap->current];
+
+    for (i32 side = 0; side < 2; ++side) {
+        i32 slot = sap->slots[index * 2 + side];
+        if (slot >= 0) endpoints[slot].owner = -1;
+    }
+
+    if (index != last) {
+        for (i32 side = 0; side < 2; ++side) {
+            i32 slot                     = sap->slots[last * 2 + side];
+            sap->slots[index * 2 + side] = slot;
+            if (slot >= 0) endpoints[slot].owner = index * 2 + side;
+        }
+    }
+}
+
+static int CompareSweepEndpoints(const void *a, const void *b)
+{
+    f32 va = ((const SweepEndpoint *)a)->value;
+    f32 vb = ((const SweepEndpoint *)b)->value;
+    return (va > vb) - (va < vb);
+}
+
+static void UpdateSweepAndPrune(SweepAndPrune *sap, Asteroid *asteroids, i32 asteroid_count)
+{
+    SweepEndpoint *endpoints = sap->endpoints[sap->current];
+
+    //======== Refresh endpoint values and drop removed asteroids =========
+    i32 count = 0;
+    for (i32 i = 0; i < sap->endpoint_count; ++i) {
+        SweepEndpoint e = endpoints[i];
+        if (e.owner < 0 || sap->slots[e.owner] < 0) continue;
+
+        Asteroid *a     = &asteroids[e.owner >> 1];
+        f32       value = a->position.x + ((e.owner & 1) ? a->bounding_radius : -a->bounding_radius);
+
+        if (fabsf(value - e.value) > SWEEP_REINSERT_DISTANCE) {
+            // NOTE: Wrapped around the world edge. Both endpoints jumped by the same amount, so whichever
+            // is seen first marks the asteroid for re-insertion and the other one is skipped above.
+            sap->slots[(e.owner & ~1) + 0] = -1;
+            sap->slots[(e.owner & ~1) + 1] = -1;
+            continue;
+        }
+
+        endpoints[count++] = (SweepEndpoint){value, e.owner};
+    }
+
+    //======== Insertion sort; nearly linear thanks to frame-to-frame coherence =========
+    for (i32 i = 1; i < count; ++i) {
+        SweepEndpoint e = endpoints[i];
+        i32           j = i - 1;
+        while (j >= 0 && endpoints[j].value > e.value) {
+            endpoints[j + 1] = endpoints[j];
+            j--;
+        }
+        endpoints[j + 1] = e;
+    }
+
+    //======== Merge in new and wrapped asteroids =========
+    i32 pending_count = 0;
+    f32 min_y         = 0.0f;
+    f32 max_y         = 0.0f;
+    f32 max_radius    = 0.0f;
+    for (i32 i = 0; i < asteroid_count; ++i) {
+        Asteroid *a = &asteroids[i];
+        min_y       = (i == 0 || a->position.y < min_y) ? a->position.y : min_y;
+        max_y       = (i == 0 || a->position.y > max_y) ? a->position.y : max_y;
+        max_radius  = si_max(max_radius, a->bounding_radius);
+
+        if (sap->slots[i * 2] >= 0) continue;
+        sap->pending[pending_count++] = (SweepEndpoint){a->position.x - a->bounding_radius, i * 2 + 0};
+        sap->pending[pending_count++] = (SweepEndpoint){a->position.x + a->bounding_radius, i * 2 + 1};
+    }
+
+    if (pending_count > 0) {
+        qsort(sap->pending, pending_count, sizeof(sap->pending[0]), CompareSweepEndpoints);
+
+        SweepEndpoint *merged = sap->endpoints[sap->current ^ 1];
+        i32            i = 0, p = 0, m = 0;
+        while (i < count && p < pending_count) {
+            merged[m++] = (endpoints[i].value <= sap->pending[p].value) ? endpoints[i++] : sap->pending[p++];
+        }
+        while (i < count) merged[m++] = endpoints[i++];
+        while (p < pending_count) merged[m++] = sap->pending[p++];
+
+        sap->current ^= 1;
+        endpoints = merged;
+        count     = m;
+    }
+
+    sap->endpoint_count = count;
+    for (i32 i = 0; i < count; ++i) {
+        sap->slots[endpoints[i].owner] = i;
+    }
+
+    // Rows at least one max-size overlap tall, so every overlapping pair sits in the same or an adjacent row
+    sap->min_y         = min_y;
+    sap->bucket_height = si_max(2.0f * max_radius, (max_y - min_y) / (SWEEP_MAX_BUCKETS - 1));
+    sap->bucket_height = si_max(sap->bucket_height, 1.0f);
+    sap->bucket_count  = (i32)((max_y - min_y) / sap->bucket_height) + 1;
+}
+
+// Sweeps the sorted list and reports every pair whose bounds overlap on both axes.
+static void FindSweepAndPrunePairs(SweepAndPrune *sap, Asteroid *asteroids, SweepPairFunction function, void *user_data)
+{
+    SweepEndpoint *endpoints = sap->endpoints[sap->current];
+
+    sap->pair_tests = 0;
+    for (i32 i = 0; i < sap->bucket_count; ++i) {
+        sap->bucket_heads[i] = -1;
+    }
+
+    for (i32 i = 0; i < sap->endpoint_count; ++i) {
+        i32 owner = endpoints[i].owner;
+        i32 a     = owner >> 1;
+
+        if (owner & 1) {
+            i32 prev = sap->active_prev[a];
+            i32 next = sap->active_next[a];
+            if (prev >= 0) {
+                sap->active_next[prev] = next;
+            } else {
+                sap->bucket_heads[sap->active_bucket[a]] = next;
+            }
+            if (next >= 0) sap->active_prev[next] = prev;
+            continue;
+        }
+
+        // NOTE: Positions may have been nudged by contacts earlier in this sweep, so clamp to the row range
+        i32 bucket = (i32)((asteroids[a].position.y - sap->min_y) / sap->bucket_height);
+        bucket     = (i32)Clamp(bucket, 0, sap->bucket_count - 1);
+
+        i32 first = si_max(bucket - 1, 0);
+        i32 last  = si_min(bucket + 1, sap->bucket_count - 1);
+        for (i32 row = first; row <= last; ++row) {
+            for (i32 b = sap->bucket_heads[row]; b >= 0; b = sap->active_next[b]) {
+                sap->pair_tests++;
+                if (fabsf(asteroids[a].position.y - asteroids[b].position.y) <=
+                    asteroids[a].bounding_radius + asteroids[b].bounding_radius) {
+                    function(user_data, a, b);
+                }
+            }
+        }
+
+        sap->active_bucket[a] = bucket;
+        sap->active_prev[a]   = -1;
+        sap->active_next[a]   = sap->bucket_heads[bucket];
+        if (sap->bucket_heads[bucket] >= 0) sap->active_prev[sap->bucket_heads[bucket]] = a;
+        sap->bucket_heads[bucket] = a;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef SWEEP_AND_PRUNE_HEADER_GUARD
+#define SWEEP_AND_PRUNE_HEADER_GUARD
+
+#include "types.h"
+
+// Moves larger than this between two updates (wrapping at the world edge, teleports) are re-inserted through
+// the merge step instead of being insertion-sorted across the whole endpoint list.
+#define SWEEP_REINSERT_DISTANCE 256.0f
+
+#define SWEEP_MAX_BUCKETS 1024
+
+typedef struct SweepEndpoint {
+    f32 value;
+    i32 owner; // asteroid_index * 2 + is_max, -1 = removed
+} SweepEndpoint;
+
+// Incremental sweep-and-prune along the x axis. The sorted endpoint list is kept between ticks, so the
+// per-tick sort is an insertion sort over an almost sorted array.
+typedef struct SweepAndPrune {
+    i32           current;
+    i32           endpoint_count;
+    SweepEndpoint endpoints[2][ASTEROID_BUFFER_CAPACITY * 2];
+
+    // Endpoint index of each (asteroid_index * 2 + is_max), -1 while waiting to be inserted
+    i32 slots[ASTEROID_BUFFER_CAPACITY * 2];
+
+    SweepEndpoint pending[ASTEROID_BUFFER_CAPACITY * 2];
+
+    // The active set of the sweep is bucketed by y (intrusive lists), so an interval is only tested against
+    // active intervals in neighbouring rows. A plain active list grows with the world width and makes the
+    // sweep O(n^1.5) on large, evenly filled worlds.
+    f32 min_y;
+    f32 bucket_height;
+    i32 bucket_count;
+    i32 bucket_heads[SWEEP_MAX_BUCKETS];
+    i32 active_next[ASTEROID_BUFFER_CAPACITY];
+    i32 active_prev[ASTEROID_BUFFER_CAPACITY];
+    i32 active_bucket[ASTEROID_BUFFER_CAPACITY];
+
+    i32 pair_tests;
+} SweepAndPrune;
+
+#endif // SWEEP_AND_PRUNE_HEADER_GUARD